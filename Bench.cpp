@@ -0,0 +1,292 @@
+// FILE: Bench.cpp
+//       A benchmark program for the IntSet data type. Times add,
+//       contains, remove, unionWith, intersect, subtract, isSubsetOf
+//       and operator== over a sweep of set sizes, value distributions
+//       and overlap ratios, and writes the results to cout as JSON.
+//       Usage: benchmark [--quick]
+//              (--quick sweeps only the small sizes, briefly)
+
+#include "IntSet.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+using namespace std;
+
+enum Distribution { DENSE, SPARSE, CLUSTERED, RANDOM };
+
+const char* const DISTRIBUTION_NAMES[] =
+   { "dense", "sparse", "clustered", "random" };
+const int DISTRIBUTION_COUNT = 4;
+const int FULL_SIZES[] = { 1000, 10000, 100000, 1000000 };
+const int QUICK_SIZES[] = { 1000, 10000 };
+const double OVERLAPS[] = { 0.0, 0.5, 1.0 };
+const int CLUSTER_RUN = 64; // Consecutive values per cluster.
+const double FULL_MIN_SECONDS = 0.1;
+const double QUICK_MIN_SECONDS = 0.02;
+
+struct Timing
+{
+   double nsPerOp;
+   double opsPerSec;
+   double allocsPerOp;
+   long   reps;
+};
+
+// Every allocation the program makes goes through the operator new
+// defined below, which counts it here.
+atomic<long> allocations(0);
+long sink = 0; // Results are added in here so no work is optimized away.
+
+// PROTOTYPES for functions used by this benchmark program:
+
+vector<int> makePool(Distribution dist, int n, mt19937& rng);
+// Pre:  n >= 1.
+// Post: 2 * n distinct values drawn as dist describes are returned:
+//       DENSE is 0 through 2n - 1; SPARSE is spread evenly over the
+//       whole range of int; CLUSTERED is runs of CLUSTER_RUN
+//       consecutive values from random starting points; RANDOM is
+//       uniformly random. The first n are for one set, the rest are
+//       values that set does not have.
+
+Timing measure(const function<void()>& setup, const function<void()>& run,
+               long opsPerRep, double minSeconds);
+// Pre:  (none)
+// Post: run has been called (after one untimed call to warm up) until
+//       at least minSeconds have been spent in it, with setup called
+//       (untimed) before each call; the time and allocations per op
+//       are returned, taking each call to run as opsPerRep ops.
+
+void report(const char* op, int size, Distribution dist, double overlap,
+            long elementsPerOp, const Timing& t);
+// Pre:  overlap is in [0, 1], or negative for an op on one set.
+// Post: t has been written to cout as a JSON object (preceded by a
+//       comma unless it is the first), with its throughput in ops and
+//       in elements (elementsPerOp to an op) per second.
+// Note: For an op on two sets, elementsPerOp is the size of both
+//       together, even when the op can stop early (isSubsetOf and
+//       operator== often do).
+
+void benchSize(int n, Distribution dist, double minSeconds, mt19937& rng);
+// Pre:  n >= 1.
+// Post: Every op has been timed and reported for sets of n values
+//       drawn as dist describes (and, for the ops on two sets, for
+//       each of OVERLAPS).
+
+void* operator new(size_t bytes)
+{
+   allocations.fetch_add(1, memory_order_relaxed);
+   void* p = malloc(bytes != 0 ? bytes : 1);
+   if (p == NULL)
+      throw bad_alloc();
+   return p;
+}
+
+void* operator new[](size_t bytes)
+{
+   return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const nothrow_t&) noexcept
+{
+   allocations.fetch_add(1, memory_order_relaxed);
+   return malloc(bytes != 0 ? bytes : 1);
+}
+
+void* operator new[](size_t bytes, const nothrow_t& tag) noexcept
+{
+   return operator new(bytes, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+   free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+   free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+   free(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept
+{
+   free(p);
+}
+
+int main(int argc, char* argv[])
+{
+   bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+   const int* sizes = quick ? QUICK_SIZES : FULL_SIZES;
+   int sizeCount = quick ? int(sizeof QUICK_SIZES / sizeof(int))
+                         : int(sizeof FULL_SIZES / sizeof(int));
+   double minSeconds = quick ? QUICK_MIN_SECONDS : FULL_MIN_SECONDS;
+   mt19937 rng(20231);   // Fixed seed: the same sets every run.
+
+   cout << fixed << setprecision(3);
+   cout << "{\n  \"benchmark\": \"IntSet\",\n"
+        << "  \"min_seconds_per_result\": " << minSeconds << ",\n"
+        << "  \"results\": [\n";
+   for (int s = 0; s < sizeCount; ++s)
+      for (int d = 0; d < DISTRIBUTION_COUNT; ++d)
+         benchSize(sizes[s], Distribution(d), minSeconds, rng);
+   cout << "\n  ],\n  \"checksum\": " << sink << "\n}" << endl;
+   return 0;
+}
+
+vector<int> makePool(Distribution dist, int n, mt19937& rng)
+{
+   vector<int> pool;
+   pool.reserve(2 * n);
+   if (dist == DENSE)
+   {
+      for (int i = 0; i < 2 * n; ++i)
+         pool.push_back(i);
+   }
+   else if (dist == SPARSE)
+   {
+      long long stride = (1LL << 32) / (2LL * n);
+      for (int i = 0; i < 2 * n; ++i)
+         pool.push_back(int(INT_MIN + i * stride));
+   }
+   else
+   {
+      unordered_set<int> seen;
+      while (int(pool.size()) < 2 * n)
+      {
+         unsigned start = unsigned(rng());
+         int run = dist == CLUSTERED ? CLUSTER_RUN : 1;
+         for (int i = 0; i < run && int(pool.size()) < 2 * n; ++i)
+         {
+            int value = int(start + unsigned(i)); // Wraps, by design.
+            if (seen.insert(value).second)
+               pool.push_back(value);
+         }
+      }
+   }
+   // Which values go to which set must not depend on their order.
+   shuffle(pool.begin(), pool.begin() + n, rng);
+   shuffle(pool.begin() + n, pool.end(), rng);
+   return pool;
+}
+
+Timing measure(const function<void()>& setup, const function<void()>& run,
+               long opsPerRep, double minSeconds)
+{
+   setup();
+   run();   // Warm-up: caches, lazily built indexes and so on.
+
+   double seconds = 0;
+   long allocated = 0;
+   long reps = 0;
+   while (seconds < minSeconds)
+   {
+      setup();
+      long before = allocations.load(memory_order_relaxed);
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      run();
+      chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+      allocated += allocations.load(memory_order_relaxed) - before;
+      seconds += chrono::duration<double>(stop - start).count();
+      ++reps;
+   }
+
+   Timing t;
+   double ops = double(opsPerRep) * reps;
+   t.nsPerOp = seconds * 1e9 / ops;
+   t.opsPerSec = seconds > 0 ? ops / seconds : 0;
+   t.allocsPerOp = allocated / ops;
+   t.reps = reps;
+   return t;
+}
+
+void report(const char* op, int size, Distribution dist, double overlap,
+            long elementsPerOp, const Timing& t)
+{
+   static bool first = true;
+   if (!first)
+      cout << ",\n";
+   first = false;
+   cout << "    {\"op\": \"" << op << "\", \"size\": " << size
+        << ", \"distribution\": \"" << DISTRIBUTION_NAMES[dist] << "\", "
+        << "\"overlap\": ";
+   if (overlap < 0)
+      cout << "null";
+   else
+      cout << overlap;
+   cout << ", \"ns_per_op\": " << t.nsPerOp
+        << ", \"ops_per_sec\": " << t.opsPerSec
+        << ", \"elements_per_sec\": " << t.opsPerSec * elementsPerOp
+        << ", \"allocs_per_op\": " << t.allocsPerOp
+        << ", \"reps\": " << t.reps << "}";
+}
+
+void benchSize(int n, Distribution dist, double minSeconds, mt19937& rng)
+{
+   vector<int> pool = makePool(dist, n, rng);
+   const int* values = pool.data();      // The first set's, in the
+   IntSet a;                             // order they are added.
+   for (int i = 0; i < n; ++i)
+      a.add(values[i]);
+
+   // Lookups: every other one a hit.
+   vector<int> queries(n);
+   for (int i = 0; i < n; ++i)
+      queries[i] = i % 2 == 0 ? values[i] : pool[n + i];
+   shuffle(queries.begin(), queries.end(), rng);
+   vector<int> removals(values, values + n);
+   shuffle(removals.begin(), removals.end(), rng);
+
+   IntSet target;
+   report("add", n, dist, -1, 1, measure(
+      [&] { target = IntSet(); },
+      [&] { for (int i = 0; i < n; ++i) sink += target.add(values[i]); },
+      n, minSeconds));
+   report("contains", n, dist, -1, 1, measure(
+      [] {},
+      [&] { for (int i = 0; i < n; ++i) sink += a.contains(queries[i]); },
+      n, minSeconds));
+   report("remove", n, dist, -1, 1, measure(
+      [&] { target = IntSet(values, n); },
+      [&] { for (int i = 0; i < n; ++i) sink += target.remove(removals[i]); },
+      n, minSeconds));
+   target = IntSet();
+
+   // Ops on two sets: b has n values, overlap * n of them also in a
+   // (the rest drawn alike but not in a), added in an order of its own.
+   for (size_t o = 0; o < sizeof OVERLAPS / sizeof(double); ++o)
+   {
+      int shared = int(OVERLAPS[o] * n + 0.5);
+      vector<int> bValues(pool.begin(), pool.begin() + shared);
+      bValues.insert(bValues.end(), pool.begin() + n,
+                     pool.begin() + (2 * n - shared));
+      shuffle(bValues.begin(), bValues.end(), rng);
+      IntSet b;
+      for (int i = 0; i < n; ++i)
+         b.add(bValues[i]);
+
+      report("unionWith", n, dist, OVERLAPS[o], 2L * n, measure(
+         [] {}, [&] { sink += a.unionWith(b).size(); }, 1, minSeconds));
+      report("intersect", n, dist, OVERLAPS[o], 2L * n, measure(
+         [] {}, [&] { sink += a.intersect(b).size(); }, 1, minSeconds));
+      report("subtract", n, dist, OVERLAPS[o], 2L * n, measure(
+         [] {}, [&] { sink += a.subtract(b).size(); }, 1, minSeconds));
+      report("isSubsetOf", n, dist, OVERLAPS[o], 2L * n, measure(
+         [] {}, [&] { sink += a.isSubsetOf(b); }, 1, minSeconds));
+      report("operator==", n, dist, OVERLAPS[o], 2L * n, measure(
+         [] {}, [&] { sink += a == b; }, 1, minSeconds));
+   }
+}
@@ -0,0 +1,171 @@
+// FILE: ConcurrentIntSet.cpp - implementation file for ConcurrentIntSet
+//       class (See ConcurrentIntSet.h for documentation.)
+// INVARIANT for the ConcurrentIntSet class:
+// (1) shards[0] through shards[count - 1] are the shards; each value
+//     v is kept in the IntSet of shardOf(v) and in no other shard.
+//     shards lies within block, the memory allocated for it, at the
+//     first address there aligned to CACHE_LINE.
+// (2) A shard's set is only ever used while its lock is held (even by
+//     const member functions: IntSet's const members are safe to run
+//     alongside one another, but not alongside an add or remove on
+//     the same IntSet). Whenever more than one lock is held, they were
+//     taken in ascending order of shard, so no two threads deadlock.
+// (3) A shard's size always equals its set's size() once the thread
+//     holding its lock lets go of it; it is written only under the
+//     lock, but may be read at any time without it.
+// (4) Each shard starts on a cache line of its own and is padded to a
+//     whole number of them, so threads working on neighbouring shards
+//     do not slow each other down by writing to the same cache line.
+//
+// DOCUMENTATION for private member (helper) functions:
+//   ConcurrentShard& shardOf(int anInt) const
+//     Pre:  (none)
+//     Post: The shard anInt belongs in is returned. It is picked by
+//           the high bits of a well-mixed hash of anInt, so that the
+//           values within one shard still differ in the low bits the
+//           shard's own IntSet hashes on.
+
+#include "ConcurrentIntSet.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstddef>
+using namespace std;
+
+namespace
+{
+    const size_t CACHE_LINE = 64;
+}
+
+struct alignas(CACHE_LINE) ConcurrentShard
+{
+    mutex lock;
+    atomic<int> size;
+    IntSet set;
+    ConcurrentShard() : size(0) {}
+};
+
+ConcurrentIntSet::ConcurrentIntSet(int shard_count)
+    : count(shard_count >= 1 ? shard_count : DEFAULT_SHARDS)
+{
+    // operator new only promises alignment for fundamental types, so
+    // allocate a cache line extra and align the shards by hand (4).
+    block = new char[count * sizeof(ConcurrentShard) + CACHE_LINE];
+    size_t misalign = size_t(block) % CACHE_LINE;
+    shards = reinterpret_cast<ConcurrentShard*>(
+        block + (misalign != 0 ? CACHE_LINE - misalign : 0));
+    for(int i = 0; i < count; i++)
+        new (&shards[i]) ConcurrentShard;
+}
+
+ConcurrentIntSet::~ConcurrentIntSet()
+{
+    for(int i = 0; i < count; i++)
+        shards[i].~ConcurrentShard();
+    delete[] block;
+    shards = NULL;
+    block = NULL;
+}
+
+int ConcurrentIntSet::size() const
+{
+    int total = 0;
+    for(int i = 0; i < count; i++)
+        total += shards[i].size.load(memory_order_relaxed);
+    return total;
+}
+
+bool ConcurrentIntSet::isEmpty() const
+{
+    return size() == 0;
+}
+
+bool ConcurrentIntSet::contains(int anInt) const
+{
+    ConcurrentShard& shard = shardOf(anInt);
+    lock_guard<mutex> hold(shard.lock);
+    return shard.set.contains(anInt);
+}
+
+int ConcurrentIntSet::shardCount() const
+{
+    return count;
+}
+
+IntSet ConcurrentIntSet::snapshot() const
+{
+    for(int i = 0; i < count; i++) // All at once, in order (2).
+        shards[i].lock.lock();
+
+    IntSet all;
+    try
+    {
+        all = IntSet(size()); // Exact, with every lock held (3).
+    }
+    catch(...)
+    {   // Out of memory: let go of every shard, or every later call on
+        // the ConcurrentIntSet would wait for them forever.
+        for(int i = 0; i < count; i++)
+            shards[i].lock.unlock();
+        throw;
+    }
+    for(int i = 0; i < count; i++)
+    {   // Shards are disjoint, so their values just go one after
+        // another; each shard is let go as soon as it is copied.
+        all.used += shards[i].set.copyLive(all.data + all.used);
+        shards[i].lock.unlock();
+    }
+    sort(all.data, all.data + all.used); // Once, after letting go.
+    all.ordering = IntSet::SORTED_ORDER;
+    all.refingerprint();
+    return all;
+}
+
+void ConcurrentIntSet::DumpData(ostream& out) const
+{
+    snapshot().dumpFast(out);
+}
+
+void ConcurrentIntSet::reset()
+{
+    for(int i = 0; i < count; i++)
+    {
+        lock_guard<mutex> hold(shards[i].lock);
+        shards[i].set.reset();
+        shards[i].size.store(0, memory_order_relaxed);
+    }
+}
+
+bool ConcurrentIntSet::add(int anInt)
+{
+    ConcurrentShard& shard = shardOf(anInt);
+    lock_guard<mutex> hold(shard.lock);
+    if(!shard.set.add(anInt))
+        return false;
+    shard.size.store(shard.set.size(), memory_order_relaxed);
+    return true;
+}
+
+bool ConcurrentIntSet::remove(int anInt)
+{
+    ConcurrentShard& shard = shardOf(anInt);
+    lock_guard<mutex> hold(shard.lock);
+    if(!shard.set.remove(anInt))
+        return false;
+    shard.size.store(shard.set.size(), memory_order_relaxed);
+    return true;
+}
+
+ConcurrentShard& ConcurrentIntSet::shardOf(int anInt) const
+{
+    unsigned h = unsigned(anInt); // Finalizer of MurmurHash3 (as in
+    h ^= h >> 16;                 // IntSet::hashOf).
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    // Scale the hash down to [0, count) by its high bits, which works
+    // for any number of shards without a division.
+    return shards[(unsigned long long)h * unsigned(count) >> 32];
+}
@@ -0,0 +1,108 @@
+// FILE: ConcurrentIntSet.h - header file for ConcurrentIntSet class
+// CLASS PROVIDED: ConcurrentIntSet (a container class for a set of
+//                 int values that any number of threads may use at
+//                 once)
+//
+// A ConcurrentIntSet holds the same kind of set as an IntSet (see
+// IntSet.h), but every member function may be called from several
+// threads at the same time without any locking by the caller. The
+// values are spread by hash over a number of shards, each an IntSet
+// of its own guarded by its own lock, so calls on values that land in
+// different shards (contains as well as add and remove) never wait
+// for one another; only calls on the same shard take turns.
+//
+// NOTE: A ConcurrentIntSet keeps no membership timing across shards.
+//       DumpData and snapshot give the elements in ascending order
+//       (just as an IntSet in IntSet::SORTED_ORDER does).
+//
+// CONSTANT
+//   static const int DEFAULT_SHARDS = ____
+//     ConcurrentIntSet::DEFAULT_SHARDS is the # of shards a
+//     ConcurrentIntSet created by the default constructor has.
+//
+// CONSTRUCTOR
+//   ConcurrentIntSet(int shard_count = DEFAULT_SHARDS)
+//     Post: The invoking ConcurrentIntSet is initialized to an empty
+//           set split into shard_count shards if shard_count is >= 1,
+//           otherwise into ConcurrentIntSet::DEFAULT_SHARDS shards.
+//     Note: More shards let more threads work at once (about as many
+//           shards as threads, or a few times more, is plenty); the
+//           number of shards never changes afterwards.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   int size() const
+//     Pre:  (none)
+//     Post: Number of elements in the invoking ConcurrentIntSet is
+//           returned.
+//     Note: No lock is taken, so while other threads are adding or
+//           removing, the count returned is a sum of per-shard counts
+//           read one after another (each of them exact when read).
+//   bool isEmpty() const
+//     Pre:  (none)
+//     Post: True is returned if size() would return 0, otherwise
+//           false is returned.
+//   bool contains(int anInt) const
+//     Pre:  (none)
+//     Post: true is returned if the invoking ConcurrentIntSet has
+//           anInt as an element, otherwise false is returned.
+//   int shardCount() const
+//     Pre:  (none)
+//     Post: The # of shards of the invoking ConcurrentIntSet is
+//           returned.
+//   IntSet snapshot() const
+//     Pre:  (none)
+//     Post: An IntSet (in IntSet::SORTED_ORDER) holding the elements
+//           of the invoking ConcurrentIntSet is returned. Every shard
+//           is locked while it is taken, so the IntSet is the set as
+//           it was at one moment, not a mix of moments.
+//   void DumpData(std::ostream& out) const
+//     Pre:  (none)
+//     Post: As for IntSet::DumpData, on snapshot() (written by
+//           IntSet::dumpFast).
+//
+// MODIFICATION MEMBER FUNCTIONS
+//   void reset()
+//   bool add(int anInt)
+//   bool remove(int anInt)
+//     Pre/Post: As for the IntSet member function of the same name.
+//     Note: reset empties the shards one at a time, so an element
+//           another thread adds meanwhile may or may not survive it.
+//
+// VALUE SEMANTICS
+//   A ConcurrentIntSet cannot be copied or assigned; take a snapshot
+//   for a copy of its elements.
+
+#ifndef CONCURRENT_INT_SET_H
+#define CONCURRENT_INT_SET_H
+
+#include "IntSet.h"
+#include <iostream>
+
+struct ConcurrentShard; // One lock and its IntSet (see ConcurrentIntSet.cpp).
+
+class ConcurrentIntSet
+{
+public:
+   static const int DEFAULT_SHARDS = 16;
+   ConcurrentIntSet(int shard_count = DEFAULT_SHARDS);
+   ~ConcurrentIntSet();
+   int size() const;
+   bool isEmpty() const;
+   bool contains(int anInt) const;
+   int shardCount() const;
+   IntSet snapshot() const;
+   void DumpData(std::ostream& out) const;
+   void reset();
+   bool add(int anInt);
+   bool remove(int anInt);
+
+private:
+   ConcurrentShard* shards;
+   int   count;
+   char* block;
+   ConcurrentShard& shardOf(int anInt) const;
+   ConcurrentIntSet(const ConcurrentIntSet& src);
+   ConcurrentIntSet& operator=(const ConcurrentIntSet& rhs);
+};
+
+#endif
@@ -0,0 +1,254 @@
+// FILE: FrozenIntSet.cpp - implementation file for FrozenIntSet class
+//       (See FrozenIntSet.h for documentation.)
+// INVARIANT for the FrozenIntSet class:
+// (1) If the FrozenIntSet is open, mapping is the address of the
+//     whole file, mapped read-only, and mappedBytes is its length;
+//     otherwise mapping is NULL and mappedBytes is 0.
+// (2) The elements are data[0] through data[used - 1], in strictly
+//     ascending order; data points into the mapping, at the payload
+//     (SERIAL_HEADER_BYTES in, so 4-byte aligned). When not open,
+//     used is 0 and data is NULL.
+// (3) Nothing but open and close ever changes any member, so any
+//     number of threads may run the const member functions at once.
+//
+// DOCUMENTATION for private member (helper) functions:
+//   bool verified() const
+//     Pre:  The invoking FrozenIntSet is open.
+//     Post: true is returned if the file's checksum matches its
+//           contents and the elements are strictly ascending,
+//           otherwise false.
+
+#include "FrozenIntSet.h"
+#include "SetKernels.h"
+#include "SerialFormat.h"
+#include <fstream>
+#include <algorithm>
+#include <climits>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+namespace
+{
+    unsigned readLE32(const unsigned char* b)
+    {
+        return unsigned(b[0]) | unsigned(b[1]) << 8 |
+               unsigned(b[2]) << 16 | unsigned(b[3]) << 24;
+    }
+
+    bool littleEndian()
+    {
+        const unsigned one = 1;
+        return *reinterpret_cast<const unsigned char*>(&one) == 1;
+    }
+}
+
+FrozenIntSet::FrozenIntSet() : mapping(NULL), mappedBytes(0), data(NULL),
+                               used(0)
+{
+}
+
+FrozenIntSet::~FrozenIntSet()
+{
+    close();
+}
+
+bool FrozenIntSet::isOpen() const
+{
+    return mapping != NULL;
+}
+
+int FrozenIntSet::size() const
+{
+    return used;
+}
+
+bool FrozenIntSet::isEmpty() const
+{
+    return used == 0;
+}
+
+bool FrozenIntSet::contains(int anInt) const
+{
+    return binary_search(data, data + used, anInt);
+}
+
+bool FrozenIntSet::isSubsetOf(const IntSet& otherIntSet) const
+{
+    if(used > otherIntSet.size()) // Too many to all be in it.
+        return false;
+    if(otherIntSet.ordering == IntSet::SORTED_ORDER) // (No tombstones.)
+        return sortedIntersectionSize(data, used, otherIntSet.data,
+                                      otherIntSet.used) == used;
+    for(int i = 0; i < used; i++) // The smaller side, by the test above.
+    {
+        if(!otherIntSet.contains(data[i]))
+            return false;
+    }
+    return true;
+}
+
+int FrozenIntSet::intersectionSize(const IntSet& otherIntSet) const
+{
+    if(otherIntSet.ordering == IntSet::SORTED_ORDER)
+        return sortedIntersectionSize(data, used, otherIntSet.data,
+                                      otherIntSet.used);
+
+    int count = 0;
+    if(otherIntSet.size() <= used) // Look up the fewer values (skipping
+    {                              // otherIntSet's tombstones).
+        for(int i = 0; i < otherIntSet.used; i++)
+        {
+            if(!otherIntSet.tombstoneAt(i) && contains(otherIntSet.data[i]))
+                count++;
+        }
+    }
+    else
+    {
+        for(int i = 0; i < used; i++)
+        {
+            if(otherIntSet.contains(data[i]))
+                count++;
+        }
+    }
+    return count;
+}
+
+int FrozenIntSet::unionSize(const IntSet& otherIntSet) const
+{
+    return used + otherIntSet.size() - intersectionSize(otherIntSet);
+}
+
+int FrozenIntSet::differenceSize(const IntSet& otherIntSet) const
+{
+    return used - intersectionSize(otherIntSet);
+}
+
+double FrozenIntSet::jaccard(const IntSet& otherIntSet) const
+{
+    int both = intersectionSize(otherIntSet);
+    int either = used + otherIntSet.size() - both;
+    if(either == 0) // As for IntSet::jaccard.
+        return 1.0;
+    return double(both) / either;
+}
+
+bool FrozenIntSet::intersects(const IntSet& otherIntSet) const
+{
+    if(otherIntSet.ordering == IntSet::SORTED_ORDER)
+        return sortedIntersects(data, used, otherIntSet.data,
+                                otherIntSet.used);
+
+    if(otherIntSet.size() <= used)
+    {
+        for(int i = 0; i < otherIntSet.used; i++)
+        {
+            if(!otherIntSet.tombstoneAt(i) && contains(otherIntSet.data[i]))
+                return true; // The first one settles it.
+        }
+    }
+    else
+    {
+        for(int i = 0; i < used; i++)
+        {
+            if(otherIntSet.contains(data[i]))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool FrozenIntSet::open(const char* path, bool verify)
+{
+    close();
+    if(!littleEndian()) // The payload is used as the machine's ints.
+        return false;
+
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+        return false;
+    struct stat info;
+    if(fstat(fd, &info) != 0 ||
+       info.st_size < SERIAL_HEADER_BYTES + SERIAL_CHECKSUM_BYTES)
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t bytes = size_t(info.st_size);
+    void* m = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file open by itself.
+    if(m == MAP_FAILED)
+        return false;
+
+    // Check the header only: the payload is not touched (so not read
+    // in) until a query needs it.
+    const unsigned char* header = static_cast<const unsigned char*>(m);
+    bool ok = true;
+    for(int i = 0; i < 4; i++)
+        ok = header[i] == SERIAL_MAGIC[i] && ok;
+    unsigned count = readLE32(header + 8);
+    unsigned long long payload = readLE32(header + 12);
+    ok = ok && header[4] == SERIAL_VERSION &&
+         header[5] == SERIAL_SORTED && // Raw, and ascending.
+         header[6] == 0 && header[7] == 0 &&
+         count <= unsigned(INT_MAX) && payload == 4ULL * count &&
+         bytes == SERIAL_HEADER_BYTES + payload + SERIAL_CHECKSUM_BYTES;
+    if(!ok)
+    {
+        munmap(m, bytes);
+        return false;
+    }
+
+    mapping = m;
+    mappedBytes = bytes;
+    data = reinterpret_cast<const int*>(header + SERIAL_HEADER_BYTES);
+    used = int(count);
+    if(verify && !verified())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FrozenIntSet::close()
+{
+    if(mapping != NULL)
+        munmap(mapping, mappedBytes);
+    mapping = NULL;
+    mappedBytes = 0;
+    data = NULL;
+    used = 0;
+}
+
+bool FrozenIntSet::write(const IntSet& set, const char* path)
+{
+    IntSet sorted(set); // Shares set's arrays until setOrder sorts it.
+    sorted.setOrder(IntSet::SORTED_ORDER);
+    ofstream out(path, ios::binary | ios::trunc);
+    if(!out)
+        return false;
+    sorted.serialize(out, IntSet::RAW_ENCODING);
+    out.close();
+    return !out.fail();
+}
+
+bool FrozenIntSet::verified() const
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(mapping);
+    size_t summed = mappedBytes - SERIAL_CHECKSUM_BYTES;
+    unsigned sum = FNV_OFFSET;
+    for(size_t i = 0; i < summed; i++)
+        sum = (sum ^ bytes[i]) * FNV_PRIME;
+    if(sum != readLE32(bytes + summed))
+        return false;
+    for(int i = 1; i < used; i++)
+    {
+        if(data[i - 1] >= data[i])
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+// FILE: FrozenIntSet.h - header file for FrozenIntSet class
+// CLASS PROVIDED: FrozenIntSet (a read-only set of int values kept in
+//                 a file written by IntSet::serialize, used in place)
+//
+// A FrozenIntSet maps a serialized IntSet file into memory and answers
+// queries straight from the mapped pages: opening one reads only the
+// 16-byte header, never decodes or copies the elements, and allocates
+// nothing for them. The pages are read in by the operating system as
+// queries touch them, and are shared by every process that maps the
+// same file, so many processes can hold one large set (a blocklist,
+// say) for the memory of one, and each is ready as soon as it opens it.
+//
+// NOTE: Only a file holding the elements in ascending order, written
+//       with IntSet::RAW_ENCODING, can be used in place (varint bytes
+//       would have to be decoded first); write(set, path) writes one
+//       from any IntSet. The elements are used as the machine's own
+//       ints, so open fails on a big-endian machine.
+// NOTE: The file must not be changed or truncated while it is open;
+//       write a new file and rename it over the old one instead (a
+//       FrozenIntSet already open keeps the old contents).
+//
+// CONSTRUCTOR
+//   FrozenIntSet()
+//     Post: The invoking FrozenIntSet is not open, and is an empty set.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   bool isOpen() const
+//     Pre:  (none)
+//     Post: true is returned if the invoking FrozenIntSet has a file
+//           open, otherwise false.
+//   int size() const
+//   bool isEmpty() const
+//   bool contains(int anInt) const
+//     Pre/Post: As for the IntSet member function of the same name.
+//     Note: contains is a binary search, touching O(log n) pages.
+//   bool isSubsetOf(const IntSet& otherIntSet) const
+//   int intersectionSize(const IntSet& otherIntSet) const
+//   int unionSize(const IntSet& otherIntSet) const
+//   int differenceSize(const IntSet& otherIntSet) const
+//   double jaccard(const IntSet& otherIntSet) const
+//   bool intersects(const IntSet& otherIntSet) const
+//     Pre/Post: As for the IntSet member function of the same name,
+//           with the invoking FrozenIntSet as the invoking IntSet.
+//     Note: Nothing is allocated. When otherIntSet is in
+//           IntSet::SORTED_ORDER the two are merged (or galloped
+//           through, see SetKernels.h); otherwise each element of the
+//           smaller side is looked up in the larger.
+//
+// MODIFICATION MEMBER FUNCTIONS
+//   bool open(const char* path, bool verify = false)
+//     Pre:  (none)
+//     Post: Whatever file the invoking FrozenIntSet had open has been
+//           closed. If path names a file of the kind described above
+//           (right magic bytes, version, flags and sizes), it has
+//           been mapped, the invoking FrozenIntSet holds its elements
+//           and true is returned; otherwise false is returned and the
+//           invoking FrozenIntSet is not open.
+//     Note: Only the header is checked unless verify is true; then
+//           the checksum and the ascending order of the elements are
+//           checked as well, which reads the whole file.
+//   void close()
+//     Pre:  (none)
+//     Post: The invoking FrozenIntSet is not open, and is an empty set.
+//
+// STATIC MEMBER FUNCTION
+//   static bool write(const IntSet& set, const char* path)
+//     Pre:  (none)
+//     Post: The elements of set have been written to the file named
+//           path (replacing any file there) in the form open takes,
+//           and true is returned; false is returned if the file could
+//           not be written.
+//
+// DESTRUCTOR
+//   ~FrozenIntSet()
+//     Post: As for close().
+//
+// VALUE SEMANTICS
+//   A FrozenIntSet cannot be copied or assigned; open the same file
+//   again for another (the pages are shared all the same).
+
+#ifndef FROZEN_INT_SET_H
+#define FROZEN_INT_SET_H
+
+#include "IntSet.h"
+#include <cstddef>
+
+class FrozenIntSet
+{
+public:
+   FrozenIntSet();
+   ~FrozenIntSet();
+   bool isOpen() const;
+   int size() const;
+   bool isEmpty() const;
+   bool contains(int anInt) const;
+   bool isSubsetOf(const IntSet& otherIntSet) const;
+   int intersectionSize(const IntSet& otherIntSet) const;
+   int unionSize(const IntSet& otherIntSet) const;
+   int differenceSize(const IntSet& otherIntSet) const;
+   double jaccard(const IntSet& otherIntSet) const;
+   bool intersects(const IntSet& otherIntSet) const;
+   bool open(const char* path, bool verify = false);
+   void close();
+   static bool write(const IntSet& set, const char* path);
+
+private:
+   void*       mapping;
+   std::size_t mappedBytes;
+   const int*  data;
+   int         used;
+   bool verified() const;
+   FrozenIntSet(const FrozenIntSet& src);
+   FrozenIntSet& operator=(const FrozenIntSet& rhs);
+};
+
+#endif
@@ -2,9 +2,15 @@
 //       Implementation file for the IntStore class
 //       (See IntSet.h for documentation.)
 // INVARIANT for the IntSet class:
-// (1) Distinct int values of the IntSet are stored in a 1-D,
-//     dynamic array whose size is stored in member variable
-//     capacity; the member variable data references the array.
+// (1) Distinct int values of the IntSet are stored in a 1-D
+//     array whose size is stored in member variable capacity; the
+//     member variable data references the array. That array is
+//     either the IntSet's own member array inlineData (capacity is
+//     then INLINE_CAPACITY) or a dynamic array.
+//     Note: Any capacity up to INLINE_CAPACITY is served by
+//           inlineData, so small IntSets (including an IntSet whose
+//           contents have been moved into another IntSet) never
+//           allocate their array dynamically.
 // (2) The distinct int value with earliest membership is stored
 //     in data[0], the distinct int value with the 2nd-earliest
 //     membership is stored in data[1], and so on.
@@ -18,13 +24,20 @@
 //           existing member (such as through the add operation)
 //           has no effect on the "membership timing" of that int
 //           value.
-// (4) The # of distinct int values the IntSet currently contains
-//     is stored in the member variable used.
+//     Note: When the member variable ordering is SORTED_ORDER, the
+//           relevant distinct int values are instead stored in
+//           ascending order (data[0] is the smallest, and so on).
+// (4) The # of slots of data in use (relevant distinct int values
+//     plus tombstones, see (8)) is stored in the member variable
+//     used; the # of distinct int values the IntSet currently
+//     contains is used - tombstones.
 // (5) Except when the IntSet is empty (used == 0), ALL elements
 //     of data from data[0] until data[used - 1] contain relevant
-//     distinct int values; i.e., all relevant distinct int values
-//     appear together (no "holes" among them) starting from the
-//     beginning of the data array.
+//     distinct int values or tombstones; i.e., all relevant
+//     distinct int values appear together (no "holes" among them
+//     other than tombstones) starting from the beginning of the
+//     data array, and (2) holds for them once tombstones are
+//     skipped.
 // (6) We DON'T care what is stored in any of the array elements
 //     from data[used] through data[capacity - 1].
 //     Note: This applies also when the IntSet is empry (used == 0)
@@ -40,8 +53,68 @@
 //           the data array and used (if properly initialized and
 //           maintained) should tell which elements of the data
 //           array are actually relevant.
+// (7) The member variable layout tells how relevant values are
+//     looked up:
+//     SCANNED: index is NULL and indexCapacity is 0; data[0..used)
+//              is simply scanned (or binary searched in SORTED_ORDER,
+//              which is always SCANNED).
+//     HASHED:  index references an open-addressing (linear probing)
+//              hash table of indexCapacity slots (a power of 2)
+//              holding, for each relevant distinct int value, its
+//              position in data; empty slots hold -1. The table is
+//              never more than half full.
+//     DIRECT:  index references a table of indexCapacity slots where
+//              index[v - indexBase] holds the position in data of
+//              the relevant value v (or -1 if v is not relevant);
+//              every relevant value lies in [indexBase, indexBase +
+//              indexCapacity).
+//     Either way, each relevant position appears in exactly one slot
+//     (a tombstone's position appears in none).
+//     Note: The layout is (re)chosen by reindex() whenever the index
+//           has to be rebuilt anyway: SCANNED until used exceeds
+//           LINEAR_SCAN_LIMIT, then DIRECT if the values span a
+//           range of at most DIRECT_DENSITY slots per value (and at
+//           most MAX_DIRECT_RANGE slots in all), otherwise HASHED. An
+//           indexed IntSet that shrinks to LINEAR_SCAN_LIMIT / 2
+//           values goes back to SCANNED unless its recent mix of
+//           operations (adds and removes, counted in adds and
+//           removes) says it is churning, in which case it would
+//           only need the index again shortly.
+//     Note: Every change of layout is counted in the process-wide
+//           counters reported by layoutStats().
+// (8) While layout is not SCANNED (so never in SORTED_ORDER, where
+//     remove shifts data just as for small IntSets), remove does
+//     not shift data; it
+//     instead turns the removed value's slot into a tombstone by
+//     setting bit i % 32 of dead[i / 32] (for slot i) and counts
+//     it in tombstones. dead is NULL until the first tombstone is
+//     made and otherwise has a bit for each of the capacity slots;
+//     all bits are clear when tombstones is 0.
+//     Note: Tombstones are squeezed out (compact) once they make up
+//           more than half of the used slots, before data is
+//           resized, and before a member function that changes the
+//           IntSet walks data in order (the in-place set operations,
+//           setOrder, addAll), so removal is amortized O(1). Const
+//           member functions (DumpData, isSubsetOf, operator==,
+//           copying, serialize, and the set operations that return
+//           a new IntSet) never compact: they skip tombstones.
+// (9) A dynamic data array and the index that goes with it may be
+//     shared by several IntSets that are copies of one another: the
+//     member variable shared is then not NULL and references the
+//     count of IntSets sharing them (shared is NULL while the arrays
+//     are the IntSet's own). Shared arrays are never written to (so
+//     they never hold tombstones); an IntSet detaches from them
+//     first, taking a copy of its own unless it turns out to be the
+//     only one left. dead is never shared.
+//     Note: A copy is made from a const IntSet, possibly by several
+//           threads at once, so the count is created lazily (by the
+//           first copy) through a compare-and-swap on shared: one
+//           count is published, and the losers' counts are dropped.
+// (10) hashSum is the sum (modulo 2^64) of fingerprintOf(v) over the
+//      relevant values v. Being a sum, it does not depend on the
+//      order of the values, or on how they are laid out.
 //
-// DOCUMENTATION for private member (helper) function:
+// DOCUMENTATION for private member (helper) functions:
 //   void resize(int new_capacity)
 //     Pre:  (none)
 //           Note: Recall that one of the things a constructor
@@ -51,7 +124,8 @@
 //                 be used within constructors unless it is at
 //                 a point where the class invariant has already
 //                 been made to hold true.
-//     Post: The capacity (size of the dynamic array) of the
+//     Post: Any tombstones are squeezed out first (see compact()).
+//           The capacity (size of the dynamic array) of the
 //           invoking IntSet is changed to new_capacity...
 //           ...EXCEPT when new_capacity would not allow the
 //           invoking IntSet to preserve current contents (i.e.,
@@ -70,205 +144,2597 @@
 //           If reallocation of dynamic array is unsuccessful, an
 //           error message to the effect is displayed and the
 //           program unconditionally terminated.
+//   void detach()
+//     Pre:  (none)
+//     Post: data and index are the invoking IntSet's own (shared is
+//           NULL), copied from the shared arrays if other IntSets
+//           still share them. The collection represented is
+//           unchanged.
+//     Note: Called at the start of every member function that may
+//           write to data or index.
+//   void releaseArrays()
+//     Pre:  (none)
+//     Post: The invoking IntSet's share of data and index has been
+//           given up (the arrays are deallocated if no other IntSet
+//           shares them), and dead has been deallocated. The member
+//           variables themselves are left unchanged.
+//   void releaseData()
+//     Pre:  data is not shared.
+//     Post: The array data references has been deallocated, unless
+//           it is inlineData (which is part of the IntSet itself).
+//           data itself is left unchanged.
+//   IntSetShare* joinShare() const
+//     Pre:  data is a dynamic array.
+//     Post: The count of IntSets sharing the invoking IntSet's arrays
+//           (created, counting the invoking IntSet alone, if it had
+//           none) has been incremented for one more IntSet and is
+//           returned. Safe to call from several threads at once.
+//   void grow()
+//     Pre:  used < INT_MAX
+//     Post: The capacity of the invoking IntSet has been changed (as
+//           by resize()) to what its growth policy gives for the
+//           current capacity, or to used + 1 if that is more.
+//   int find(int anInt) const
+//     Pre:  (none)
+//     Post: The position of anInt in data is returned if anInt is a
+//           relevant value of the invoking IntSet, otherwise -1 is
+//           returned.
+//   void indexInsert(int position)
+//     Pre:  layout is not SCANNED, data[position] is not yet
+//           referenced by index, and index has a free slot for it
+//           (if HASHED) or covers its value (if DIRECT).
+//     Post: A slot of index now references position.
+//   void indexErase(int position)
+//     Pre:  layout is not SCANNED and index references position.
+//     Post: The slot referencing position has been freed; if HASHED,
+//           later entries of its probe run have been shifted back so
+//           that no lookup is cut short by the freed slot.
+//   bool indexCovers(int anInt) const
+//     Pre:  layout is not SCANNED and anInt has just been placed at
+//           data[used - 1].
+//     Post: true is returned if index can take anInt without being
+//           rebuilt (the HASHED table stays at most half full; the
+//           DIRECT table has a slot for anInt), otherwise false is
+//           returned.
+//   void rebuildIndex(Layout new_layout, int new_index_capacity)
+//     Pre:  tombstones is 0; new_layout is not SCANNED; for HASHED,
+//           new_index_capacity is a power of 2 and is at least
+//           2 * used; for DIRECT, indexBase has been set and every
+//           relevant value lies in [indexBase, indexBase +
+//           new_index_capacity).
+//     Post: index is reallocated with new_index_capacity slots of
+//           new_layout and references every position from 0 through
+//           used - 1.
+//   void fillIndex()
+//     Pre:  tombstones is 0.
+//     Post: Every slot of index is cleared and then every position
+//           from 0 through used - 1 is inserted again (nothing is
+//           done if layout is SCANNED).
+//   void reindex()
+//     Pre:  tombstones is 0.
+//     Post: The layout has been chosen afresh as described in (7)
+//           for the current contents of data, index has been rebuilt
+//           for it (or released, if SCANNED), and any change of
+//           layout has been counted.
+//     Note: Used after data has been filled in bulk and whenever the
+//           index outgrows its table.
+//   void noteOperation(int& counter)
+//     Pre:  counter is adds or removes.
+//     Post: counter has been incremented; adds and removes have both
+//           been halved if they have grown past OP_MIX_WINDOW
+//           together, so that they reflect recent operations.
+//   bool churning() const
+//     Pre:  (none)
+//     Post: true is returned if at least a third of the recent
+//           operations (see noteOperation()) were removes.
+//   int addPending(int n)
+//     Pre:  tombstones is 0, n >= 0, and data[used..used + n) (within
+//           capacity) holds ints to be added, in the order given.
+//     Post: Those ints that are not already relevant values have
+//           been added, each once (at its first occurrence, or in
+//           ascending order for SORTED_ORDER), and the # added is
+//           returned.
+//     Note: Duplicates among the pending ints are weeded out with a
+//           single pass over a scratch hash table of their own (a
+//           scan of the ints kept so far, if there are only a few;
+//           one sort, for SORTED_ORDER), and the index is rebuilt
+//           once at the end rather than as each int goes in.
+//   void disown()
+//     Pre:  data, dead and index are now owned by another IntSet.
+//     Post: The invoking IntSet is an empty IntSet with no arrays
+//           (see the note to (1)); nothing has been deallocated.
+//   int* sortedCopy() const
+//     Pre:  (none)
+//     Post: A newly allocated array of size() ints, holding the
+//           relevant values in ascending order, is returned; the
+//           caller is responsible for delete[]-ing it.
+//   int combineSorted(SetOp op, const int* a, int na, const int* b,
+//                     int nb, int* out) const
+//     Pre:  As for the SetKernels function op stands for
+//           (sortedUnion, sortedIntersect, sortedDifference or
+//           sortedSymmetricDifference), except that out may not be a.
+//     Post: As for that function. When workersFor(na + nb) > 1, a
+//           and b are cut at the same pivot values (taken evenly from
+//           the larger) into one pair of ranges per worker; each
+//           worker counts its pair's result with
+//           sortedIntersectionSize, and then writes it at the offset
+//           the counts of the pairs before it sum to.
+//   int filterBy(const int* values, int n, const IntSet& probe,
+//                bool keep_found, int* out) const
+//     Pre:  out has room for n ints and overlaps neither values nor
+//           probe's arrays (probe is only read, by contains, so the
+//           workers can share it).
+//     Post: The ints of values[0..n) for which probe.contains(...)
+//           == keep_found have been written to out, in the same
+//           order, and their # is returned. Split over workersFor(n)
+//           workers as combineSorted is, by ranges of positions.
+//   static int workersFor(int n)
+//     Pre:  (none)
+//     Post: The # of threads to split an operation over n ints
+//           across is returned (1: run it on the calling thread).
+//   void compact()
+//     Pre:  (none)
+//     Post: All tombstones have been squeezed out of data, with the
+//           relevant values keeping their relative order (2), and
+//           index has been updated to the new positions.
+//     Note: Only member functions that change the IntSet anyway
+//           compact it; const member functions skip the tombstones
+//           instead (see tombstoneAt), so that any number of threads
+//           may run them on one IntSet at once.
+//   bool tombstoneAt(int position) const
+//     Pre:  0 <= position < used.
+//     Post: true is returned if data[position] is a tombstone,
+//           otherwise false.
+//   int copyLive(int* out) const
+//     Pre:  out has room for size() ints.
+//     Post: The relevant values have been copied to out, in order
+//           (tombstones skipped), and their # (size()) is returned.
+//   const int* denseData(int*& scratch) const
+//     Pre:  (none)
+//     Post: An array of the size() relevant values, in order, is
+//           returned: data itself if there are no tombstones (and
+//           scratch is NULL), otherwise a newly allocated copy (also
+//           stored in scratch, which the caller passes to deleteInts
+//           with size()).
+//   const int* sortedData(int* small, int*& scratch) const
+//     Pre:  small has room for INLINE_CAPACITY ints.
+//     Post: An array of the size() relevant values, in ascending
+//           order, is returned: data itself in SORTED_ORDER (and
+//           scratch is NULL), otherwise a sorted copy, made in small
+//           if it fits there (scratch is then NULL too) or else newly
+//           allocated (and also stored in scratch, which the caller
+//           passes to deleteInts with size()).
+//   void adoptData(int* values, int n)
+//     Pre:  data is not shared and tombstones is 0; values holds the
+//           n new values of the IntSet, in order, and is either a
+//           newly allocated array of exactly n ints (n greater than
+//           INLINE_CAPACITY) or the caller's scratch space.
+//     Post: The old array has been deallocated; the values now live
+//           in values itself (capacity n) if it was allocated, or
+//           have been copied into inlineData otherwise; used is n.
+//           index and hashSum are left for the caller to redo.
+//   static unsigned hashOf(int anInt)
+//     Pre:  (none)
+//     Post: A well-mixed hash of anInt is returned (the low bits are
+//           used to pick a slot of index).
+//   static unsigned long long fingerprintOf(int anInt)
+//     Pre:  (none)
+//     Post: A well-mixed 64-bit hash of anInt is returned (what anInt
+//           contributes to hashSum).
+//   void refingerprint()
+//     Pre:  (none)
+//     Post: hashSum has been recomputed from scratch (for use after
+//           the values have been rewritten wholesale).
+//   bool loadText(ChunkReader readChunk, void* source)
+//     Pre:  readChunk(source, buffer, n) puts up to n more bytes of
+//           the text into buffer and returns how many (0 at the end
+//           of the text, or -1 if it cannot be read).
+//     Post: As for loadFrom, on the whole text readChunk gives.
 
 #include "IntSet.h"
+#include "SetKernels.h"
+#include "MemoryResource.h"
+#include "SerialFormat.h"
 #include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <utility>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <functional>
+#include <locale>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 using namespace std;
 
+struct IntSetShare // How many IntSets share a data array and its index.
+{
+    atomic<int> owners;
+    IntSetShare() : owners(1) {}
+};
+
 void IntSet::resize(int new_capacity)
 {
+    compact(); // Never carry tombstones over into the new array.
+
     if(new_capacity <= 0) // Ensure the new capacity is an acceptable value.
-        capacity = DEFAULT_CAPACITY;
+        new_capacity = DEFAULT_CAPACITY;
     else if(new_capacity < used)
-        capacity = used;
-    else
-        capacity = new_capacity;
+        new_capacity = used;
 
-    int* newData = new int[capacity]; // Dynamically allocate new array
+    int* newData;
+    if(new_capacity <= INLINE_CAPACITY) // Small enough to live inside the
+    {                                   // IntSet itself.
+        new_capacity = INLINE_CAPACITY;
+        if(data == inlineData) // Already there.
+            return;
+        newData = inlineData;
+    }
+    else
+        newData = newInts(new_capacity); // Dynamically allocate new array
 
     for(int i = 0;i < used;i++)
         newData[i] = data[i];
 
-    delete[] data; // Delete old array
+    releaseData(); // Delete old array
+    deleteDead();  // The old bits were all clear (no tombstones), and
+                   // the next tombstone allocates them at the new size.
     data = newData; // Reassign invoking data array to newData array.
+                    // (positions are unchanged, so index stays valid)
+    capacity = new_capacity;
 }
 
-IntSet::IntSet(int initial_capacity) : capacity(initial_capacity), used(0)
+void IntSet::detach()
 {
-    if(initial_capacity <= 0) // If the initial capacity passed is not
-        capacity = DEFAULT_CAPACITY; // an acceptable value, we use the DEF_CAP.
+    IntSetShare* share = shared.load(memory_order_relaxed);
+    if(share == NULL)
+        return;
 
-    data = new int[capacity]; // Dynamically allocate memory of space capacity.
+    if(share->owners.load(memory_order_acquire) > 1)
+    {   // Others still read the arrays, so copy them...
+        int* ownData = newInts(capacity);
+        for(int i = 0; i < used; i++)
+            ownData[i] = data[i];
+        int* ownIndex = NULL;
+        if(index != NULL)
+        {
+            ownIndex = newInts(indexCapacity);
+            for(int i = 0; i < indexCapacity; i++)
+                ownIndex[i] = index[i];
+        }
+        if(share->owners.fetch_sub(1, memory_order_acq_rel) == 1)
+        {   // ...unless they all let go of them meanwhile.
+            deleteInts(data, capacity);
+            deleteInts(index, indexCapacity);
+            deleteShare(share);
+        }
+        data = ownData;
+        index = ownIndex;
+    }
+    else
+        deleteShare(share); // Only the invoking IntSet is left to use them.
+    shared.store(NULL, memory_order_relaxed);
 }
 
-IntSet::IntSet(const IntSet& src) : capacity(src.capacity), used(src.used)
+void IntSet::releaseArrays()
 {
-    data = new int[capacity];
+    IntSetShare* share = shared.load(memory_order_relaxed);
+    if(share == NULL || share->owners.fetch_sub(1, memory_order_acq_rel) == 1)
+    {   // No other IntSet uses them.
+        releaseData();
+        deleteInts(index, indexCapacity);
+        deleteShare(share);
+    }
+    deleteDead();
+}
 
-    for(int i = 0;i < used; i++)
-        data[i] = src.data[i]; // Copy data from the src up to used.
+void IntSet::releaseData()
+{
+    if(data != inlineData) // inlineData goes away with the IntSet.
+        deleteInts(data, capacity);
 }
 
-IntSet::~IntSet()
+int* IntSet::newInts(int n) const
 {
-   delete[] data; // Deallocate memory
-   data = NULL; // Ensure data is NULL after destructed.
+    return static_cast<int*>(memory->allocate(sizeof(int) * (n > 0 ? n : 1),
+                                              alignof(int)));
 }
 
-IntSet& IntSet::operator=(const IntSet& rhs)
+void IntSet::deleteInts(int* array, int n) const
 {
-    // If object you pass is the same
-    // return back the same object.
-    if (this == &rhs)
-        return *this;
+    if(array != NULL)
+        memory->deallocate(array, sizeof(int) * (n > 0 ? n : 1), alignof(int));
+}
+
+void IntSet::deleteDead()
+{
+    if(dead != NULL)
+        memory->deallocate(dead, sizeof(unsigned) * ((capacity + 31) / 32),
+                           alignof(unsigned));
+    dead = NULL;
+}
 
-    int* temp = new int[rhs.capacity]; // Temp dynamic array
+IntSetShare* IntSet::newShare() const
+{
+    return new (memory->allocate(sizeof(IntSetShare), alignof(IntSetShare)))
+               IntSetShare;
+}
 
-    for (int i = 0; i < rhs.used; i++)
-        temp[i] = rhs.data[i];
+void IntSet::deleteShare(IntSetShare* share) const
+{
+    if(share == NULL)
+        return;
+    share->~IntSetShare();
+    memory->deallocate(share, sizeof(IntSetShare), alignof(IntSetShare));
+}
 
-    delete [] data; // Deallocate original dynamic array.
+IntSetShare* IntSet::joinShare() const
+{
+    IntSetShare* share = shared.load(memory_order_acquire);
+    if(share == NULL)
+    {   // The first copy: publish a new count (of the invoking IntSet
+        // alone), unless another thread copying it got there first.
+        IntSetShare* fresh = newShare();
+        if(shared.compare_exchange_strong(share, fresh,
+                                          memory_order_acq_rel,
+                                          memory_order_acquire))
+            share = fresh;
+        else
+            deleteShare(fresh); // share is now the other thread's.
+    }
+    share->owners.fetch_add(1, memory_order_relaxed);
+    return share;
+}
 
-    data = temp; // Reassign to temp dynamic array.
-    capacity = rhs.capacity;
-    used = rhs.used;
+void IntSet::compact()
+{
+    if(tombstones == 0) // Nothing to squeeze out.
+        return;
 
-    return *this;
+    int kept = 0;
+    for(int i = 0; i < used; i++)
+    {
+        if((dead[i / 32] & (1U << (i % 32))) == 0) // Slide each relevant value
+            data[kept++] = data[i];                // down past the tombstones.
+    }
+    for(int i = 0; i < (used + 31) / 32; i++)
+        dead[i] = 0;
+
+    used = kept;
+    tombstones = 0;
+    fillIndex(); // Every value after the first tombstone has moved.
 }
 
-int IntSet::size() const
+bool IntSet::tombstoneAt(int position) const
 {
-    return used; // Used is always updated when an
-}                // an element is removed or added.
+    return tombstones > 0 &&
+           (dead[position / 32] & (1U << (position % 32))) != 0;
+}
 
-bool IntSet::isEmpty() const
+int IntSet::copyLive(int* out) const
 {
-    if(used == 0) // If the used index is zero, the data array is empty
-        return true; // otherwise, it is not empty.
+    int n = 0;
+    for(int i = 0; i < used; i++)
+    {
+        if(!tombstoneAt(i))
+            out[n++] = data[i];
+    }
+    return n;
+}
+
+const int* IntSet::denseData(int*& scratch) const
+{
+    scratch = NULL;
+    if(tombstones == 0) // The usual case: data itself will do.
+        return data;
+    scratch = newInts(size());
+    copyLive(scratch);
+    return scratch;
+}
+
+const int* IntSet::sortedData(int* small, int*& scratch) const
+{
+    scratch = NULL;
+    if(ordering == SORTED_ORDER) // Never holds tombstones.
+        return data;
+    int n = size();
+    int* sorted = small;
+    if(n > INLINE_CAPACITY)
+        sorted = scratch = newInts(n);
+    copyLive(sorted);
+    sort(sorted, sorted + n);
+    return sorted;
+}
+
+void IntSet::adoptData(int* values, int n)
+{
+    releaseData();
+    deleteDead(); // Sized for the old array (and all clear).
+    if(n <= INLINE_CAPACITY)
+    {   // values is the caller's scratch space: copy it in.
+        for(int i = 0; i < n; i++)
+            inlineData[i] = values[i];
+        data = inlineData;
+        capacity = INLINE_CAPACITY;
+    }
     else
-        return false;
+    {
+        data = values;
+        capacity = n;
+    }
+    used = n;
 }
 
-bool IntSet::contains(int anInt) const
+unsigned IntSet::hashOf(int anInt)
+{
+    unsigned h = unsigned(anInt); // Finalizer of MurmurHash3, so that
+    h ^= h >> 16;                 // clustered IDs still spread evenly
+    h *= 0x85ebca6bU;             // over the low bits of the hash.
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+unsigned long long IntSet::fingerprintOf(int anInt)
+{
+    unsigned long long h = unsigned(anInt); // Finalizer of SplitMix64:
+    h += 0x9e3779b97f4a7c15ULL;             // 64 well-mixed bits, so a
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL; // sum over the elements
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL; // rarely collides.
+    return h ^ (h >> 31);
+}
+
+void IntSet::refingerprint()
 {
-    if(used > 0) // As long as we have elements in our IntSet
+    compact();
+    hashSum = 0;
+    for(int i = 0; i < used; i++)
+        hashSum += fingerprintOf(data[i]);
+}
+
+static atomic<long> switchesToScanned(0); // Process-wide layout
+static atomic<long> switchesToHashed(0);  // switch counters (see
+static atomic<long> switchesToDirect(0);  // layoutStats()).
+static atomic<int> threadSetting(0); // See setParallelism() (0: as many
+static atomic<int> cutoffSetting(IntSet::PARALLEL_CUTOFF); // as the
+                                                 // hardware runs).
+
+static void runParallel(int workers, const function<void(int)>& work)
+{   // Runs work(0) through work(workers - 1), one per thread; whatever
+    // threads cannot be started are done on the calling thread.
+    thread* helpers = new thread[workers - 1];
+    int started = 0;
+    try
     {
-        for(int i = 0;i < used; i++) // Traverse until the used index checking
-        {                            // if the element exists within
-            if(anInt == data[i])     // the invoking data array.
-                return true;
-        }
+        for(; started < workers - 1; started++)
+            helpers[started] = thread(work, started + 1);
     }
-    return false;
+    catch(const system_error&)
+    {
+    }
+    for(int w = started + 1; w < workers; w++)
+        work(w);
+    work(0);
+    for(int i = 0; i < started; i++)
+        helpers[i].join();
+    delete[] helpers;
 }
-bool IntSet::isSubsetOf(const IntSet& otherIntSet) const
+
+void IntSet::grow()
 {
-   if(isEmpty()) // If the invoking set is empty, it will
-        return true; // always be a subset of otherIntSet.
-   else
-   {
-       for(int i = 0;i < used; i++)
-       {
-           if(!otherIntSet.contains(data[i])) // If not every element of the
-                return false; // invoking set is in otherIntSet, return false.
-       }
-       return true;
-   }
+    int wanted = growth(capacity); // A policy that overflowed (negative)
+    resize(wanted > used ? wanted : used + 1); // or fell short gets one more.
 }
 
-void IntSet::DumpData(ostream& out) const
-{  // already implemented ... DON'T change anything
-    if (used > 0)
+int IntSet::growGeometric(int current_capacity)
+{
+    double next = 1.5 * current_capacity + 1; // In double, so it can
+    return next < INT_MAX ? int(next) : INT_MAX; // saturate, not overflow.
+}
+
+int IntSet::growDoubling(int current_capacity)
+{
+    if(current_capacity > INT_MAX / 2)
+        return INT_MAX;
+    return current_capacity > 0 ? 2 * current_capacity : DEFAULT_CAPACITY;
+}
+
+int IntSet::growFixedStep(int current_capacity)
+{
+    return current_capacity > INT_MAX - GROWTH_STEP ? INT_MAX
+                                                    : current_capacity + GROWTH_STEP;
+}
+
+int IntSet::find(int anInt) const
+{
+    if(ordering == SORTED_ORDER)
     {
-        out << data[0];
-        for (int i = 1; i < used; ++i)
-            out << "  " << data[i];
+        const int* at = lower_bound(data, data + used, anInt);
+        if(at != data + used && *at == anInt)
+            return int(at - data);
+        return -1;
+    }
+
+    if(layout == SCANNED) // Few enough values that a (vectorized) scan
+        return scanFind(data, used, anInt); // is cheapest.
+
+    if(layout == DIRECT)
+    {   // Wraps around for values below indexBase, too.
+        unsigned offset = unsigned(anInt) - unsigned(indexBase);
+        return offset < unsigned(indexCapacity) ? index[offset] : -1;
     }
+
+    unsigned mask = unsigned(indexCapacity - 1);
+    unsigned slot = hashOf(anInt) & mask;
+    while(index[slot] != -1) // Walk the probe run until an empty slot.
+    {
+        if(data[index[slot]] == anInt)
+            return index[slot];
+        slot = (slot + 1) & mask;
+    }
+    return -1;
 }
 
-IntSet IntSet::unionWith(const IntSet& otherIntSet) const
+void IntSet::indexInsert(int position)
 {
-   IntSet unionSet = (*this);
-   int otherSize = otherIntSet.size(); // Safely store size
+    if(layout == DIRECT)
+    {
+        index[unsigned(data[position]) - unsigned(indexBase)] = position;
+        return;
+    }
 
-   for(int i = 0; i < otherSize; i++)
-   {
-       if(unionSet.contains(otherIntSet.data[i]) == false) // If both sets contain
-            unionSet.add(otherIntSet.data[i]); // the value, add it to the union and return.
-   }
-   return unionSet;
+    unsigned mask = unsigned(indexCapacity - 1);
+    unsigned slot = hashOf(data[position]) & mask;
+    while(index[slot] != -1)
+        slot = (slot + 1) & mask;
+    index[slot] = position;
 }
 
-IntSet IntSet::intersect(const IntSet& otherIntSet) const
+void IntSet::indexErase(int position)
 {
-    IntSet intersectSet = (*this);
+    if(layout == DIRECT)
+    {
+        index[unsigned(data[position]) - unsigned(indexBase)] = -1;
+        return;
+    }
 
-    for(int i = 0; i < size(); i++) // Must use size of invoking set
-    {                               // to reach every value of the initial set.
-        if(otherIntSet.contains(data[i]) == false)
-            intersectSet.remove(data[i]); // Remove element if it is
-    }                                     // not contained in both sets.
-    return intersectSet;
+    unsigned mask = unsigned(indexCapacity - 1);
+    unsigned hole = hashOf(data[position]) & mask;
+    while(index[hole] != position)
+        hole = (hole + 1) & mask;
+
+    // Backward-shift deletion: pull later members of the probe run
+    // into the hole unless that would move them before their home.
+    unsigned next = (hole + 1) & mask;
+    while(index[next] != -1)
+    {
+        unsigned home = hashOf(data[index[next]]) & mask;
+        if(((next - home) & mask) >= ((next - hole) & mask))
+        {
+            index[hole] = index[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index[hole] = -1;
+}
+
+bool IntSet::indexCovers(int anInt) const
+{
+    if(layout == DIRECT)
+        return unsigned(anInt) - unsigned(indexBase) < unsigned(indexCapacity);
+    return 2 * (used - tombstones) <= indexCapacity;
 }
 
-IntSet IntSet::subtract(const IntSet& otherIntSet) const
+void IntSet::rebuildIndex(Layout new_layout, int new_index_capacity)
 {
-    IntSet subSet = (*this); // create a copy of the invoking intSet
-    int otherSize = otherIntSet.size(); // using the operator= overloaded function.
+    if(new_layout != layout || new_index_capacity != indexCapacity)
+    {   // Otherwise the table already allocated is reused as is.
+        deleteInts(index, indexCapacity);
+        layout = new_layout;
+        indexCapacity = new_index_capacity;
+        index = newInts(indexCapacity);
+    }
+    fillIndex();
+}
+
+void IntSet::reindex()
+{
+    Layout before = layout;
+
+    if(ordering == INSERTION_ORDER && used > LINEAR_SCAN_LIMIT)
+    {
+        int low = data[0], high = data[0]; // Exact span of the values.
+        for(int i = 1; i < used; i++)
+        {
+            low = min(low, data[i]);
+            high = max(high, data[i]);
+        }
+        long long range = (long long)high - low + 1;
+
+        if(range <= (long long)DIRECT_DENSITY * used &&
+           range <= MAX_DIRECT_RANGE)
+        {   // Dense enough: one slot per value in the span, plus a
+            // quarter more on each side so that values added in
+            // sequence, ascending or descending, still fit. Each
+            // rebuild widens the window by half, so a run of such
+            // adds rebuilds it O(log n) times (no slot beyond the
+            // range of int, though).
+            long long slack = range / 4 + 1;
+            long long base = max((long long)INT_MIN, low - slack);
+            long long top = min((long long)INT_MAX, high + slack);
+            indexBase = int(base);
+            rebuildIndex(DIRECT, int(top - base + 1));
+        }
+        else
+        {
+            int slots = 1; // Size the index so that it is at most half full.
+            while(slots < 2 * used)
+                slots *= 2;
+            rebuildIndex(HASHED, slots);
+        }
+    }
+    else
+    {
+        deleteInts(index, indexCapacity);
+        index = NULL;
+        indexCapacity = 0;
+        layout = SCANNED;
+    }
 
-    for(int i = 0; i < otherSize; i++)
+    if(layout != before) // Count the switch.
     {
-        if(subSet.contains(otherIntSet.data[i])) // if the copy contains an element
-            subSet.remove(otherIntSet.data[i]); // from otherIntSet, remove from subSet.
+        if(layout == SCANNED)
+            switchesToScanned.fetch_add(1, memory_order_relaxed);
+        else if(layout == HASHED)
+            switchesToHashed.fetch_add(1, memory_order_relaxed);
+        else
+            switchesToDirect.fetch_add(1, memory_order_relaxed);
     }
-    return subSet;
 }
 
-void IntSet::reset()
+void IntSet::noteOperation(int& counter)
 {
-    used = 0;
+    counter++;
+    if(adds + removes > OP_MIX_WINDOW) // Let older operations fade out.
+    {
+        adds /= 2;
+        removes /= 2;
+    }
 }
 
-bool IntSet::add(int anInt)
+bool IntSet::churning() const
+{
+    return 3 * removes >= adds + removes && removes > 0;
+}
+
+int* IntSet::sortedCopy() const
+{
+    int* sorted = newInts(size());
+    int n = copyLive(sorted);
+    if(ordering == INSERTION_ORDER)
+        sort(sorted, sorted + n);
+    return sorted;
+}
+
+int IntSet::combineSorted(SetOp op, const int* a, int na, const int* b,
+                          int nb, int* out) const
 {
-    if(contains(anInt) == false)
+    int workers = workersFor(na + nb);
+    if(workers == 1)
     {
-        if(used >= capacity)     // If the size is at capacity, resize
-            resize(int(1.5 * capacity) + 1); // the entire array in resize().
+        switch(op)
+        {
+        case UNION_OP:     return sortedUnion(a, na, b, nb, out);
+        case INTERSECT_OP: return sortedIntersect(a, na, b, nb, out);
+        case DIFFERENCE_OP: return sortedDifference(a, na, b, nb, out);
+        default:           return sortedSymmetricDifference(a, na, b, nb,
+                                                            out);
+        }
+    }
 
-        data[used] = anInt;
-        used++; // Increment the used index to supplement the value added.
-        return true;
+    int* aCut = newInts(3 * (workers + 1)); // Worker w takes a[aCut[w]..
+    int* bCut = aCut + (workers + 1);       // aCut[w + 1]) and the same
+    int* offset = bCut + (workers + 1);     // of b, writing from offset[w].
+    const int* big = na >= nb ? a : b;
+    int nBig = na >= nb ? na : nb;
+    aCut[0] = bCut[0] = 0;
+    aCut[workers] = na;
+    bCut[workers] = nb;
+    for(int w = 1; w < workers; w++)
+    {   // Every value below the pivot goes to workers before w.
+        int pivot = big[(long long)nBig * w / workers];
+        aCut[w] = int(lower_bound(a, a + na, pivot) - a);
+        bCut[w] = int(lower_bound(b, b + nb, pivot) - b);
     }
-    return false;
+
+    runParallel(workers, [&](int w)
+    {
+        int ia = aCut[w], la = aCut[w + 1] - ia;
+        int ib = bCut[w], lb = bCut[w + 1] - ib;
+        int both = sortedIntersectionSize(a + ia, la, b + ib, lb);
+        switch(op)
+        {
+        case UNION_OP:      offset[w + 1] = la + lb - both; break;
+        case INTERSECT_OP:  offset[w + 1] = both; break;
+        case DIFFERENCE_OP: offset[w + 1] = la - both; break;
+        default:            offset[w + 1] = la + lb - 2 * both; break;
+        }
+    });
+    offset[0] = 0;
+    for(int w = 0; w < workers; w++) // Counts into starting offsets.
+        offset[w + 1] += offset[w];
+    runParallel(workers, [&](int w)
+    {
+        int ia = aCut[w], la = aCut[w + 1] - ia;
+        int ib = bCut[w], lb = bCut[w + 1] - ib;
+        int* to = out + offset[w];
+        int room = offset[w + 1] - offset[w]; // Exactly, so no store
+        switch(op)                            // spills into the next.
+        {
+        case UNION_OP:
+            sortedUnion(a + ia, la, b + ib, lb, to, room);
+            break;
+        case INTERSECT_OP:
+            sortedIntersect(a + ia, la, b + ib, lb, to, room);
+            break;
+        case DIFFERENCE_OP:
+            sortedDifference(a + ia, la, b + ib, lb, to, room);
+            break;
+        default:
+            sortedSymmetricDifference(a + ia, la, b + ib, lb, to);
+        }
+    });
+
+    int total = offset[workers];
+    deleteInts(aCut, 3 * (workers + 1));
+    return total;
 }
 
-bool IntSet::remove(int anInt)
+int IntSet::filterBy(const int* values, int n, const IntSet& probe,
+                     bool keep_found, int* out) const
 {
-    if(contains(anInt))
+    int workers = workersFor(n);
+    if(workers == 1)
     {
-        for(int i = 0; i < used; i++) // Traverse entire array up to used
-        {                             // to try and find anInt.
-            if(data[i] == anInt) // Side comment: if you could return the index of an element from
-            {                    // the contains function, it would be much less expensive to remove.
-                for(int j = i; j < used - 1; j++) // Move every element after anInt
-                    data[j] = data[j + 1];        // back one index.
-                used--;
-                return true;
-            }
+        int k = 0;
+        for(int i = 0; i < n; i++)
+        {
+            if(probe.contains(values[i]) == keep_found)
+                out[k++] = values[i];
         }
+        return k;
     }
-    return false;
+
+    // One flag per int, so the second pass need not look it up again.
+    unsigned char* keep = static_cast<unsigned char*>(
+        memory->allocate(n, alignof(unsigned char)));
+    int* offset = newInts(workers + 1);
+    runParallel(workers, [&](int w)
+    {
+        int from = int((long long)n * w / workers);
+        int to = int((long long)n * (w + 1) / workers);
+        int kept = 0;
+        for(int i = from; i < to; i++)
+        {
+            keep[i] = probe.contains(values[i]) == keep_found;
+            kept += keep[i];
+        }
+        offset[w + 1] = kept;
+    });
+    offset[0] = 0;
+    for(int w = 0; w < workers; w++)
+        offset[w + 1] += offset[w];
+    runParallel(workers, [&](int w)
+    {
+        int from = int((long long)n * w / workers);
+        int to = int((long long)n * (w + 1) / workers);
+        int k = offset[w];
+        for(int i = from; i < to; i++)
+        {
+            if(keep[i])
+                out[k++] = values[i];
+        }
+    });
+
+    int total = offset[workers];
+    memory->deallocate(keep, n, alignof(unsigned char));
+    deleteInts(offset, workers + 1);
+    return total;
 }
 
-bool operator==(const IntSet& is1, const IntSet& is2)
+int IntSet::workersFor(int n)
 {
-    if(is1.size()!=is2.size()) // if they are not the same size,
-        return false;          // they can not be logically equal.
+    int threads = parallelThreads();
+    if(threads <= 1 || n < parallelCutoff() || n < 2)
+        return 1;
+    return threads < n ? threads : n; // Never more workers than ints.
+}
+
+void IntSet::fillIndex()
+{
+    unsigned mask = unsigned(indexCapacity - 1);
+
+    for(int i = 0; i < indexCapacity; i++)
+        index[i] = -1; // Every slot starts out empty.
+    if(layout == DIRECT)
+    {
+        for(int i = 0; i < used; i++)
+            index[unsigned(data[i]) - unsigned(indexBase)] = i;
+        return;
+    }
+    for(int i = 0; i < used; i++)
+    {
+        unsigned slot = hashOf(data[i]) & mask;
+        while(index[slot] != -1)
+            slot = (slot + 1) & mask;
+        index[slot] = i;
+    }
+}
+
+IntSet::IntSet(int initial_capacity, MemoryResource* resource) : capacity(initial_capacity), used(0),
+                                       tombstones(0), dead(NULL),
+                                       index(NULL), indexCapacity(0),
+                                       shared(NULL),
+                                       ordering(INSERTION_ORDER),
+                                       layout(SCANNED), indexBase(0),
+                                       adds(0), removes(0),
+                                       growth(growGeometric),
+                                       memory(resource != NULL ? resource :
+                                              newDeleteResource()),
+                                       hashSum(0)
+{
+    if(initial_capacity <= 0) // If the initial capacity passed is not
+        capacity = DEFAULT_CAPACITY; // an acceptable value, we use the DEF_CAP.
 
-    if(is1.isSubsetOf(is2) && is2.isSubsetOf(is1)) // if both sets are subsets
-        return true;                               // of each other, they are equal.
+    if(capacity <= INLINE_CAPACITY) // Small IntSets need no allocation.
+    {
+        capacity = INLINE_CAPACITY;
+        data = inlineData;
+    }
     else
-        return false;
+        data = newInts(capacity); // Dynamically allocate memory of space capacity.
+}
+
+IntSet::IntSet(const int* values, int n, MemoryResource* resource)
+    : IntSet(n, resource)
+{
+    addAll(values, n);
+}
+
+IntSet::IntSet(initializer_list<int> values, MemoryResource* resource)
+    : IntSet(int(values.size()), resource)
+{
+    addAll(values.begin(), int(values.size()));
+}
+
+IntSet::IntSet(const IntSet& src) : IntSet(src, NULL)
+{
+}
+
+IntSet::IntSet(const IntSet& src, MemoryResource* resource)
+    : capacity(src.capacity), tombstones(0), dead(NULL), index(NULL),
+      indexCapacity(src.indexCapacity), shared(NULL),
+      ordering(src.ordering), layout(src.layout),
+      indexBase(src.indexBase), adds(src.adds), removes(src.removes),
+      growth(src.growth),
+      memory(resource != NULL ? resource : newDeleteResource()),
+      hashSum(src.hashSum)
+{
+    used = src.size(); // Only src's relevant values are copied, so the
+                       // copy has no tombstones (src is not changed).
+    if(capacity <= INLINE_CAPACITY || used <= INLINE_CAPACITY)
+    {                     // Few enough values to copy into inlineData,
+        capacity = INLINE_CAPACITY; // whatever room src had spare.
+        data = inlineData;
+    }
+    else if(memory == src.memory && src.tombstones == 0)
+    {   // Share src's arrays until one of the two changes (9).
+        shared.store(src.joinShare(), memory_order_relaxed);
+        data = src.data;
+        index = src.index;
+        return;
+    }
+    else // Arrays from another resource (or with tombstones to leave
+        data = newInts(capacity); // out) are copied into the copy's own.
+
+    src.copyLive(data);
+
+    if(src.layout != SCANNED)
+    {
+        index = newInts(indexCapacity);
+        if(src.tombstones == 0) // Positions are the same in the copy, so
+        {                       // src's index can be copied slot for slot.
+            for(int i = 0; i < indexCapacity; i++)
+                index[i] = src.index[i];
+        }
+        else // Values after a tombstone have moved down.
+            fillIndex();
+    }
+}
+
+IntSet::IntSet(IntSet&& src) noexcept : data(src.data), capacity(src.capacity),
+                                        used(src.used),
+                                        tombstones(src.tombstones),
+                                        dead(src.dead), index(src.index),
+                                        indexCapacity(src.indexCapacity),
+                                        shared(src.shared.load(
+                                            memory_order_relaxed)),
+                                        ordering(src.ordering),
+                                        layout(src.layout),
+                                        indexBase(src.indexBase),
+                                        adds(src.adds), removes(src.removes),
+                                        growth(src.growth),
+                                        memory(src.memory),
+                                        hashSum(src.hashSum)
+{
+    if(src.data == src.inlineData) // Inline ints cannot be taken over,
+    {                              // only copied (and there are few).
+        data = inlineData;
+        for(int i = 0; i < used; i++)
+            data[i] = src.data[i];
+    }
+    src.disown(); // The arrays now belong to the new IntSet.
+}
+
+void IntSet::disown()
+{
+    data = inlineData;
+    capacity = INLINE_CAPACITY;
+    used = 0;
+    tombstones = 0;
+    dead = NULL;
+    index = NULL;
+    indexCapacity = 0;
+    shared.store(NULL, memory_order_relaxed);
+    layout = SCANNED;
+    adds = 0;
+    removes = 0;
+    hashSum = 0;
+}
+
+IntSet::~IntSet()
+{
+   releaseArrays(); // Deallocate memory (unless still shared)
+   data = NULL; // Ensure data is NULL after destructed.
+   index = NULL;
+   dead = NULL;
+}
+
+IntSet& IntSet::operator=(const IntSet& rhs)
+{
+    // If object you pass is the same
+    // return back the same object.
+    if (this == &rhs)
+        return *this;
+
+    // Copy into the invoking IntSet's own resource (sharing rhs's arrays
+    // if rhs allocates from it too), then take the copy's arrays over;
+    // if the copy fails, *this is left as it was.
+    IntSet copy(rhs, memory);
+    return *this = std::move(copy);
+}
+
+IntSet& IntSet::operator=(IntSet&& rhs)
+{
+    if (this == &rhs)
+        return *this;
+    if (memory != rhs.memory) // Arrays from another resource cannot be
+        return *this = static_cast<const IntSet&>(rhs); // taken over.
+
+    releaseArrays(); // Give up the old arrays and take over rhs's.
+
+    data = rhs.data;
+    capacity = rhs.capacity;
+    used = rhs.used;
+    if (rhs.data == rhs.inlineData) // Copied rather than taken over,
+    {                               // as in the move constructor.
+        data = inlineData;
+        for (int i = 0; i < used; i++)
+            data[i] = rhs.data[i];
+    }
+    tombstones = rhs.tombstones;
+    dead = rhs.dead;
+    index = rhs.index;
+    indexCapacity = rhs.indexCapacity;
+    shared.store(rhs.shared.load(memory_order_relaxed), memory_order_relaxed);
+    ordering = rhs.ordering;
+    layout = rhs.layout;
+    indexBase = rhs.indexBase;
+    adds = rhs.adds;
+    removes = rhs.removes;
+    growth = rhs.growth;
+    hashSum = rhs.hashSum;
+    rhs.disown();
+
+    return *this;
+}
+
+int IntSet::size() const
+{
+    return used - tombstones; // Used and tombstones are always updated
+}                             // when an element is removed or added.
+
+bool IntSet::isEmpty() const
+{
+    if(size() == 0) // If there are no relevant values, the IntSet is empty
+        return true; // otherwise, it is not empty.
+    else
+        return false;
+}
+
+bool IntSet::contains(int anInt) const
+{
+    return find(anInt) != -1; // Hash lookup once the IntSet has an index.
+}
+
+IntSet::Order IntSet::order() const
+{
+    return ordering;
+}
+
+bool IntSet::isSubsetOf(const IntSet& otherIntSet) const
+{
+   if(isEmpty()) // If the invoking set is empty, it will
+        return true; // always be a subset of otherIntSet.
+   else
+   {
+       for(int i = 0;i < used; i++)
+       {
+           if(tombstoneAt(i)) // Not an element (see (8)).
+                continue;
+           if(!otherIntSet.contains(data[i])) // If not every element of the
+                return false; // invoking set is in otherIntSet, return false.
+       }
+       return true;
+   }
+}
+
+int IntSet::intersectionSize(const IntSet& otherIntSet) const
+{   // (SORTED_ORDER IntSets never have tombstones, see (8).)
+    if(ordering == SORTED_ORDER && otherIntSet.ordering == SORTED_ORDER)
+        return sortedIntersectionSize(data, used, otherIntSet.data,
+                                      otherIntSet.used);
+
+    bool mine = size() <= otherIntSet.size();
+    const IntSet& small = mine ? *this : otherIntSet;
+    const IntSet& big = mine ? otherIntSet : *this;
+    int count = 0;
+    for(int i = 0; i < small.used; i++) // Look up the fewer values.
+    {
+        if(!small.tombstoneAt(i) && big.contains(small.data[i]))
+            count++;
+    }
+    return count;
+}
+
+int IntSet::unionSize(const IntSet& otherIntSet) const
+{
+    return size() + otherIntSet.size() - intersectionSize(otherIntSet);
+}
+
+int IntSet::differenceSize(const IntSet& otherIntSet) const
+{
+    return size() - intersectionSize(otherIntSet);
+}
+
+double IntSet::jaccard(const IntSet& otherIntSet) const
+{
+    int both = intersectionSize(otherIntSet);
+    int either = size() + otherIntSet.size() - both;
+    if(either == 0) // Two empty IntSets are equal (see operator==).
+        return 1.0;
+    return double(both) / either;
+}
+
+bool IntSet::intersects(const IntSet& otherIntSet) const
+{
+    if(ordering == SORTED_ORDER && otherIntSet.ordering == SORTED_ORDER)
+        return sortedIntersects(data, used, otherIntSet.data,
+                                otherIntSet.used);
+
+    bool mine = size() <= otherIntSet.size();
+    const IntSet& small = mine ? *this : otherIntSet;
+    const IntSet& big = mine ? otherIntSet : *this;
+    for(int i = 0; i < small.used; i++)
+    {
+        if(!small.tombstoneAt(i) && big.contains(small.data[i]))
+            return true; // The first one settles it.
+    }
+    return false;
+}
+
+namespace
+{
+    const int MAX_INT_CHARS = 11; // "-2147483648"
+    const int DUMP_BUFFER_BYTES = 1 << 16;
+    const char DIGIT_PAIRS[] = // "00", "01", ..., "99", back to back.
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    // Writes anInt in decimal so that it ends just before end; returns
+    // where it starts. Two digits are peeled off per division.
+    char* formatInt(int anInt, char* end)
+    {
+        unsigned v = anInt < 0 ? 0U - unsigned(anInt) : unsigned(anInt);
+        while(v >= 100)
+        {
+            const char* pair = DIGIT_PAIRS + 2 * (v % 100);
+            v /= 100;
+            *--end = pair[1];
+            *--end = pair[0];
+        }
+        if(v >= 10)
+        {
+            *--end = DIGIT_PAIRS[2 * v + 1];
+            *--end = DIGIT_PAIRS[2 * v];
+        }
+        else
+            *--end = char('0' + v);
+        if(anInt < 0)
+            *--end = '-';
+        return end;
+    }
+
+    // True if out << anInt would write plain decimal digits: no other
+    // base, no '+', no padding, and no digit grouping from the locale.
+    bool plainDecimal(ostream& out)
+    {
+        ios::fmtflags base = out.flags() & ios::basefield;
+        return (base == ios::dec || base == 0) &&
+               !(out.flags() & ios::showpos) && out.width() == 0 &&
+               use_facet< numpunct<char> >(out.getloc()).grouping().empty();
+    }
+}
+
+void IntSet::DumpData(ostream& out) const
+{  // already implemented ... DON'T change anything
+    if (tombstones > 0)
+    {   // (A const member cannot squeeze them out, see (8), so dump a
+        // copy, which is made without them.)
+        IntSet(*this).DumpData(out);
+        return;
+    }
+    if (used > 0)
+    {
+        out << data[0];
+        for (int i = 1; i < used; ++i)
+            out << "  " << data[i];
+    }
+}
+
+void IntSet::dumpFast(ostream& out) const
+{  // Tombstones are skipped, so the rest are in the order of (2).
+    if (size() == 0)
+        return;
+    bool first = true;
+    if (!plainDecimal(out))
+    {   // Let out format each int as it has been told to.
+        for (int i = 0; i < used; ++i)
+        {
+            if (tombstoneAt(i))
+                continue;
+            if (!first)
+                out << "  ";
+            out << data[i];
+            first = false;
+        }
+        return;
+    }
+
+    char buffer[DUMP_BUFFER_BYTES];
+    char digits[MAX_INT_CHARS];
+    int n = 0;
+    for (int i = 0; i < used; ++i)
+    {
+        if (tombstoneAt(i))
+            continue;
+        if (n > DUMP_BUFFER_BYTES - (2 + MAX_INT_CHARS)) // No room for
+        {                                                // one more.
+            out.write(buffer, n);
+            n = 0;
+            if (!out)
+                return;
+        }
+        if (!first)
+        {
+            buffer[n++] = ' ';
+            buffer[n++] = ' ';
+        }
+        first = false;
+        char* start = formatInt(data[i], digits + MAX_INT_CHARS);
+        while (start != digits + MAX_INT_CHARS)
+            buffer[n++] = *start++;
+    }
+    out.write(buffer, n);
+}
+
+namespace
+{
+    class ByteWriter // Buffers bytes for out, checksumming them.
+    {
+    public:
+        ByteWriter(ostream& out) : out(out), n(0), sum(FNV_OFFSET) {}
+        void put(unsigned byte)
+        {
+            if(n == int(sizeof buffer))
+                flush();
+            buffer[n++] = (unsigned char)byte;
+            sum = (sum ^ (byte & 0xFF)) * FNV_PRIME;
+        }
+        void put32(unsigned value) // Little-endian.
+        {
+            for(int shift = 0; shift < 32; shift += 8)
+                put(value >> shift);
+        }
+        void putVarint(unsigned long long value) // 7 bits a byte, low
+        {                                        // first; high bit set
+            while(value >= 0x80)                 // on all but the last.
+            {
+                put(unsigned(value & 0x7F) | 0x80);
+                value >>= 7;
+            }
+            put(unsigned(value));
+        }
+        unsigned checksum() const { return sum; }
+        void flush()
+        {
+            out.write(reinterpret_cast<const char*>(buffer), n);
+            n = 0;
+        }
+    private:
+        ostream& out;
+        unsigned char buffer[4096];
+        int n;
+        unsigned sum;
+    };
+
+    class ByteReader // Takes bytes from in's buffer, checksumming them.
+    {
+    public:
+        ByteReader(istream& in) : source(in.rdbuf()), ok(source != NULL),
+                                  sum(FNV_OFFSET) {}
+        unsigned get()
+        {
+            int c = ok ? source->sbumpc() : char_traits<char>::eof();
+            if(c == char_traits<char>::eof())
+            {
+                ok = false;
+                return 0;
+            }
+            sum = (sum ^ unsigned(c & 0xFF)) * FNV_PRIME;
+            return unsigned(c & 0xFF);
+        }
+        unsigned get32()
+        {
+            unsigned value = 0;
+            for(int shift = 0; shift < 32; shift += 8)
+                value |= get() << shift;
+            return value;
+        }
+        void getBytes(unsigned char* to, long long n) // In bulk.
+        {
+            if(ok && source->sgetn(reinterpret_cast<char*>(to), n) != n)
+                ok = false;
+            for(long long i = 0; ok && i < n; i++)
+                sum = (sum ^ to[i]) * FNV_PRIME;
+        }
+        bool good() const { return ok; }
+        unsigned checksum() const { return sum; }
+    private:
+        streambuf* source;
+        bool ok;
+        unsigned sum;
+    };
+
+    // The most ints deserialize allocates for before any have been read:
+    // beyond that, the array grows as they arrive (see deserialize).
+    const int DESERIALIZE_FIRST_INTS = 1 << 16;
+
+    unsigned long long zigzag(long long delta) // 0, -1, 1, -2, ... to
+    {                                          // 0, 1, 2, 3, ...
+        return ((unsigned long long)delta << 1) ^
+               (unsigned long long)(delta >> 63);
+    }
+
+    int varintBytes(unsigned long long value)
+    {
+        int bytes = 1;
+        while(value >= 0x80)
+        {
+            value >>= 7;
+            bytes++;
+        }
+        return bytes;
+    }
+}
+
+void IntSet::serialize(ostream& out, Encoding encoding) const
+{
+    bool varint = encoding == DELTA_VARINT_ENCODING;
+    unsigned long long payload = 4ULL * unsigned(size());
+    if(varint)
+    {   // Sized up front, since the header says how long it is.
+        payload = 0;
+        long long previous = 0;
+        for(int i = 0; i < used; i++)
+        {
+            if(tombstoneAt(i)) // Tombstones are skipped here and below.
+                continue;
+            payload += varintBytes(zigzag(data[i] - previous));
+            previous = data[i];
+        }
+    }
+    if(payload > 0xFFFFFFFFULL) // The header has 32 bits for it: write
+    {                           // nothing rather than a wrong length.
+        out.setstate(ios::badbit);
+        return;
+    }
+
+    ByteWriter w(out);
+    for(int i = 0; i < 4; i++)
+        w.put(SERIAL_MAGIC[i]);
+    w.put(SERIAL_VERSION);
+    w.put((varint ? SERIAL_DELTA_VARINT : 0) |
+          (ordering == SORTED_ORDER ? SERIAL_SORTED : 0));
+    w.put(0); // Reserved.
+    w.put(0);
+    w.put32(unsigned(size()));
+    w.put32(unsigned(payload));
+
+    long long previous = 0;
+    for(int i = 0; i < used; i++)
+    {
+        if(tombstoneAt(i))
+            continue;
+        if(varint)
+            w.putVarint(zigzag(data[i] - previous));
+        else
+            w.put32(unsigned(data[i]));
+        previous = data[i];
+    }
+    w.put32(w.checksum());
+    w.flush();
+}
+
+bool IntSet::deserialize(istream& in)
+{
+    ByteReader r(in);
+    bool ok = true;
+    for(int i = 0; i < 4; i++)
+        ok = r.get() == SERIAL_MAGIC[i] && ok;
+    unsigned version = r.get();
+    unsigned flags = r.get();
+    unsigned reserved = r.get();
+    reserved |= r.get();
+    unsigned count = r.get32();
+    unsigned payload = r.get32();
+
+    bool varint = (flags & SERIAL_DELTA_VARINT) != 0;
+    ok = ok && r.good() && version == SERIAL_VERSION &&
+         (flags & ~(SERIAL_DELTA_VARINT | SERIAL_SORTED)) == 0 &&
+         reserved == 0 && count <= unsigned(INT_MAX) &&
+         (varint ? payload >= count && payload <= 5ULL * count
+                 : payload == 4ULL * count);
+    if(!ok)
+    {   // Nothing is allocated for a header that makes no sense.
+        in.setstate(ios::failbit);
+        return false;
+    }
+
+    // The count is not trusted with an allocation of its own (a corrupt
+    // header could claim two billion elements): the array starts small
+    // and doubles as the elements arrive, so such a header fails on the
+    // bytes missing rather than on allocating for them.
+    int n = int(count);
+    IntSet loaded(min(n, DESERIALIZE_FIRST_INTS), memory);
+    loaded.ordering = flags & SERIAL_SORTED ? SORTED_ORDER : INSERTION_ORDER;
+    loaded.growth = growth;
+    auto makeRoom = [&loaded, n](int decoded)
+    {   // Doubles the array, keeping the decoded elements (no more than
+        // n in all, and no index to keep up while decoding).
+        loaded.used = decoded;
+        loaded.resize(int(min((long long)n, 2LL * loaded.capacity)));
+    };
+    if(varint)
+    {
+        long long value = 0;
+        unsigned read = 0; // Payload bytes taken so far.
+        for(int i = 0; i < n && ok; i++)
+        {
+            if(i == loaded.capacity)
+                makeRoom(i);
+            unsigned long long zz = 0;
+            int shift = 0;
+            unsigned byte;
+            do
+            {
+                byte = r.get();
+                read++;
+                zz |= (unsigned long long)(byte & 0x7F) << shift;
+                shift += 7;
+            } while((byte & 0x80) != 0 && shift < 35 && r.good());
+            long long delta = (long long)(zz >> 1) ^ -(long long)(zz & 1);
+            value += delta;
+            ok = r.good() && (byte & 0x80) == 0 && value >= INT_MIN &&
+                 value <= INT_MAX;
+            loaded.data[i] = int(value);
+        }
+        ok = ok && read == payload;
+    }
+    else
+    {   // Read straight into place, as much as fits at a time, then put
+        // the bytes in host order.
+        for(int i = 0; i < n && ok; )
+        {
+            if(i == loaded.capacity)
+                makeRoom(i);
+            int m = min(loaded.capacity, n) - i;
+            unsigned char* bytes =
+                reinterpret_cast<unsigned char*>(loaded.data + i);
+            r.getBytes(bytes, 4LL * m);
+            ok = r.good();
+            for(int j = 0; j < m && ok; j++)
+            {
+                const unsigned char* b = bytes + 4 * j;
+                loaded.data[i + j] = int(unsigned(b[0]) | unsigned(b[1]) << 8 |
+                                         unsigned(b[2]) << 16 |
+                                         unsigned(b[3]) << 24);
+            }
+            i += m;
+        }
+    }
+    unsigned expected = r.checksum();
+    ok = ok && r.get32() == expected && r.good();
+
+    if(ok)
+    {   // Repeated elements would break every invariant: reject them.
+        loaded.used = n;
+        loaded.reindex();
+        for(int i = 0; i < n && ok; i++)
+        {
+            if(loaded.ordering == SORTED_ORDER)
+                ok = i == 0 || loaded.data[i - 1] < loaded.data[i];
+            else
+                ok = loaded.find(loaded.data[i]) == i;
+        }
+    }
+    if(!ok)
+    {
+        in.setstate(ios::failbit);
+        return false;
+    }
+
+    loaded.refingerprint();
+    *this = std::move(loaded);
+    return true;
+}
+
+namespace
+{
+    const int LOAD_BUFFER_BYTES = 1 << 16;
+    const int LOAD_MIN_ROOM = 4096; // Fewest ints gathered per bulk add.
+
+    bool isBlank(char c) // As isspace in the "C" locale.
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    class IntTokenizer // Splits text into ints, a chunk at a time.
+    {
+    public:
+        IntTokenizer() : inToken(false), negative(false), digits(false),
+                         value(0), bad(false) {}
+        // Takes the next int in [p, end) into anInt and moves p past it.
+        // false once the chunk runs out (an int cut off by the end of
+        // it is carried over into the next chunk) or the text is bad.
+        bool next(const char*& p, const char* end, int& anInt)
+        {
+            while(!bad && p != end)
+            {
+                if(!inToken)
+                {
+                    while(p != end && isBlank(*p))
+                        p++;
+                    if(p == end)
+                        return false;
+                    inToken = true;
+                    digits = false;
+                    value = 0;
+                    negative = *p == '-';
+                    if(*p == '-' || *p == '+')
+                    {
+                        p++;
+                        continue;
+                    }
+                }
+                while(p != end && unsigned(*p - '0') < 10)
+                {
+                    value = value * 10 + unsigned(*p++ - '0');
+                    digits = true;
+                    if(value > 2147483648ULL) // Out of range already (and
+                    {                         // kept from overflowing).
+                        bad = true;
+                        return false;
+                    }
+                }
+                if(p == end)
+                    return false;
+                if(!isBlank(*p)) // Something other than a digit in it.
+                {
+                    bad = true;
+                    return false;
+                }
+                return take(anInt);
+            }
+            return false;
+        }
+        // At the end of the text: true if an int was cut off by it.
+        bool finish(int& anInt)
+        {
+            return inToken && !bad && take(anInt);
+        }
+        bool failed() const { return bad; }
+    private:
+        bool take(int& anInt)
+        {
+            inToken = false;
+            if(!digits || value > (negative ? 2147483648ULL : 2147483647ULL))
+            {
+                bad = true;
+                return false;
+            }
+            anInt = negative ? int(-(long long)value) : int(value);
+            return true;
+        }
+        bool inToken;
+        bool negative;
+        bool digits;
+        unsigned long long value;
+        bool bad;
+    };
+
+    int readStream(void* source, char* buffer, int n)
+    {
+        return int(static_cast<streambuf*>(source)->sgetn(buffer, n));
+    }
+
+    int readFd(void* source, char* buffer, int n)
+    {
+        ssize_t got;
+        do
+            got = ::read(*static_cast<int*>(source), buffer, n);
+        while(got < 0 && errno == EINTR);
+        return got < 0 ? -1 : int(got);
+    }
+}
+
+bool IntSet::loadFrom(istream& in)
+{
+    if(!in) // As operator>> would: a failed stream is not read.
+    {
+        in.setstate(ios::failbit);
+        return false;
+    }
+    streambuf* source = in.rdbuf();
+    bool ok = source != NULL && loadText(readStream, source);
+    in.setstate(ok ? ios::eofbit : ios::failbit);
+    return ok;
+}
+
+bool IntSet::loadFromFile(const char* path)
+{
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+        return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL); // Only a hint.
+    bool ok = loadFromFile(fd);
+    ::close(fd);
+    return ok;
+}
+
+bool IntSet::loadFromFile(int fd)
+{
+    return loadText(readFd, &fd);
+}
+
+bool IntSet::loadText(ChunkReader readChunk, void* source)
+{
+    IntSet loaded(DEFAULT_CAPACITY, memory);
+    loaded.ordering = ordering;
+    loaded.growth = growth;
+    int pending = 0; // Ints parsed into data[used..used + pending).
+    auto gather = [&loaded, &pending](int anInt)
+    {
+        if(loaded.used + pending == loaded.capacity)
+        {   // Full: weed out repeats in bulk, then make room for at
+            // least as many ints again (so the array grows
+            // geometrically, and the bulk adds are few).
+            loaded.addPending(pending);
+            pending = 0;
+            int room = max(loaded.used, LOAD_MIN_ROOM);
+            if(loaded.capacity - loaded.used < room)
+                loaded.resize(loaded.used + room);
+        }
+        loaded.data[loaded.used + pending++] = anInt;
+    };
+
+    IntTokenizer tokens;
+    char buffer[LOAD_BUFFER_BYTES];
+    int anInt;
+    int got;
+    bool malformed = false;
+    while((got = readChunk(source, buffer, LOAD_BUFFER_BYTES)) > 0)
+    {
+        if(malformed) // The rest is still read to the end, unparsed.
+            continue;
+        const char* p = buffer;
+        while(tokens.next(p, buffer + got, anInt))
+            gather(anInt);
+        malformed = tokens.failed();
+    }
+    if(got < 0 || malformed)
+        return false;
+    if(tokens.finish(anInt))
+        gather(anInt);
+    if(tokens.failed())
+        return false;
+
+    loaded.addPending(pending);
+    *this = std::move(loaded);
+    return true;
+}
+
+IntSet IntSet::unionWith(const IntSet& otherIntSet) const &
+{
+   int otherSize = otherIntSet.size(); // Safely store size
+
+   IntSet unionSet(size() + otherSize, memory); // Presized, so nothing is regrown.
+   unionSet.ordering = ordering;
+
+   if(ordering == SORTED_ORDER)
+   {
+       const int* otherSorted = otherIntSet.data;
+       int* scratch = NULL;
+       if(otherIntSet.ordering != SORTED_ORDER)
+           otherSorted = scratch = otherIntSet.sortedCopy();
+       unionSet.used = combineSorted(UNION_OP, data, used, otherSorted,
+                                     otherSize, unionSet.data);
+       otherIntSet.deleteInts(scratch, otherSize);
+       unionSet.refingerprint();
+       return unionSet;
+   }
+
+   int kept = copyLive(unionSet.data); // Invoking set's values keep their
+   int* scratch;                       // order, followed by those it lacks.
+   const int* otherValues = otherIntSet.denseData(scratch);
+   unionSet.used = kept + filterBy(otherValues, otherSize, *this, false,
+                                   unionSet.data + kept);
+   otherIntSet.deleteInts(scratch, otherSize);
+   unionSet.reindex();
+   unionSet.refingerprint();
+   return unionSet;
+}
+
+IntSet IntSet::intersect(const IntSet& otherIntSet) const &
+{
+    int mySize = size();
+    int otherSize = otherIntSet.size();
+    bool otherIsTiny = double(otherSize) * GALLOP_RATIO < mySize;
+
+    IntSet intersectSet(mySize < otherSize ? mySize : otherSize, memory);
+    intersectSet.ordering = ordering;
+
+    if(ordering == SORTED_ORDER &&
+       (otherIntSet.ordering == SORTED_ORDER || otherIsTiny))
+    {
+        const int* otherSorted = otherIntSet.data;
+        int* scratch = NULL;
+        if(otherIntSet.ordering != SORTED_ORDER) // Cheap, since it is tiny.
+            otherSorted = scratch = otherIntSet.sortedCopy();
+        intersectSet.used = combineSorted(INTERSECT_OP, data, used, otherSorted,
+                                          otherSize, intersectSet.data);
+        otherIntSet.deleteInts(scratch, otherSize);
+        intersectSet.refingerprint();
+        return intersectSet;
+    }
+
+    if(otherIsTiny) // Look up otherIntSet's few values rather than
+    {               // probing for every value of the invoking set.
+        int* positions = newInts(otherSize);
+        int found = 0;
+        for(int j = 0; j < otherIntSet.used; j++)
+        {
+            if(otherIntSet.tombstoneAt(j))
+                continue;
+            int position = find(otherIntSet.data[j]);
+            if(position != -1)
+                positions[found++] = position;
+        }
+        sort(positions, positions + found); // Back into the order of *this.
+        for(int k = 0; k < found; k++)
+            intersectSet.data[k] = data[positions[k]];
+        intersectSet.used = found;
+        deleteInts(positions, otherSize);
+    }
+    else // Keep (in order) only the values contained in both sets.
+    {
+        int* scratch;
+        intersectSet.used = filterBy(denseData(scratch), mySize, otherIntSet,
+                                     true, intersectSet.data);
+        deleteInts(scratch, mySize);
+    }
+    intersectSet.reindex();
+    intersectSet.refingerprint();
+    return intersectSet;
+}
+
+IntSet IntSet::subtract(const IntSet& otherIntSet) const &
+{
+    int mySize = size();
+    int otherSize = otherIntSet.size();
+    bool otherIsTiny = double(otherSize) * GALLOP_RATIO < mySize;
+
+    IntSet subSet(mySize, memory); // The difference is never larger than *this.
+    subSet.ordering = ordering;
+
+    if(ordering == SORTED_ORDER &&
+       (otherIntSet.ordering == SORTED_ORDER || otherIsTiny))
+    {
+        const int* otherSorted = otherIntSet.data;
+        int* scratch = NULL;
+        if(otherIntSet.ordering != SORTED_ORDER) // Cheap, since it is tiny.
+            otherSorted = scratch = otherIntSet.sortedCopy();
+        subSet.used = combineSorted(DIFFERENCE_OP, data, used, otherSorted,
+                                    otherSize, subSet.data);
+        otherIntSet.deleteInts(scratch, otherSize);
+        subSet.refingerprint();
+        return subSet;
+    }
+
+    if(otherIsTiny) // Find where otherIntSet's few values sit and copy
+    {               // the runs of *this between them across as is.
+        int* positions = newInts(otherSize + 1);
+        int found = 0;
+        for(int j = 0; j < otherIntSet.used; j++)
+        {
+            if(otherIntSet.tombstoneAt(j))
+                continue;
+            int position = find(otherIntSet.data[j]);
+            if(position != -1)
+                positions[found++] = position;
+        }
+        sort(positions, positions + found);
+        positions[found] = used; // Sentinel ending the last run.
+        int from = 0;
+        for(int k = 0; k <= found; k++)
+        {
+            for(int i = from; i < positions[k]; i++)
+            {
+                if(!tombstoneAt(i)) // Runs may hold tombstones.
+                    subSet.data[subSet.used++] = data[i];
+            }
+            from = positions[k] + 1;
+        }
+        deleteInts(positions, otherSize + 1);
+    }
+    else // Keep (in order) the values that otherIntSet does not contain.
+    {
+        int* scratch;
+        subSet.used = filterBy(denseData(scratch), mySize, otherIntSet, false,
+                               subSet.data);
+        deleteInts(scratch, mySize);
+    }
+    subSet.reindex();
+    subSet.refingerprint();
+    return subSet;
+}
+
+void IntSet::unionInPlace(const IntSet& otherIntSet)
+{
+    if(&otherIntSet == this) // Nothing to add to itself.
+        return;
+
+    detach();
+    compact(); // otherIntSet is const: its tombstones are skipped instead.
+    int otherSize = otherIntSet.size();
+
+    if(ordering == SORTED_ORDER)
+    {
+        if(otherSize == 0)
+            return;
+        int small[INLINE_CAPACITY];
+        int* scratch;
+        const int* otherSorted = otherIntSet.sortedData(small, scratch);
+        int n = used + otherSize -
+                sortedIntersectionSize(data, used, otherSorted, otherSize);
+        bool serial = workersFor(used + otherSize) == 1;
+        if(serial && n <= capacity)
+        {   // Merge from the top down, so that each of data's values is
+            // read before the merged values can reach its slot.
+            int i = used - 1;
+            int j = otherSize - 1;
+            for(int k = n - 1; j >= 0; k--)
+            {
+                if(i >= 0 && data[i] >= otherSorted[j])
+                {
+                    if(data[i] == otherSorted[j])
+                        j--;
+                    data[k] = data[i--];
+                }
+                else
+                    data[k] = otherSorted[j--];
+            }          // What is left of data is already in place.
+            used = n;
+        }
+        else
+        {   // Only when it has to grow (or the merge is split across
+            // workers): straight into an array of the exact size.
+            int result[INLINE_CAPACITY];
+            int* merged = n <= INLINE_CAPACITY ? result : newInts(n);
+            if(serial)
+                sortedUnion(data, used, otherSorted, otherSize, merged, n);
+            else
+                combineSorted(UNION_OP, data, used, otherSorted, otherSize,
+                              merged);
+            adoptData(merged, n);
+        }
+        otherIntSet.deleteInts(scratch, otherSize);
+        refingerprint();
+        return;
+    }
+
+    if(capacity < used + otherSize) // Grow once, to the most the union
+        resize(used + otherSize);   // can hold.
+    int added = 0;
+    for(int i = 0; i < otherIntSet.used; i++)
+    {   // Appended past used, so find() only ever sees the original
+        // values (otherIntSet's values do not repeat among themselves).
+        if(!otherIntSet.tombstoneAt(i) && find(otherIntSet.data[i]) == -1)
+            data[used + added++] = otherIntSet.data[i];
+    }
+    if(added > 0)
+    {
+        for(int i = used; i < used + added; i++)
+            hashSum += fingerprintOf(data[i]);
+        used += added;
+        reindex();
+    }
+}
+
+void IntSet::intersectInPlace(const IntSet& otherIntSet)
+{
+    if(&otherIntSet == this) // Everything is in itself.
+        return;
+
+    detach();
+    compact();
+    int otherSize = otherIntSet.size();
+    bool otherIsTiny = double(otherSize) * GALLOP_RATIO < used;
+
+    if(ordering == SORTED_ORDER &&
+       (otherIntSet.ordering == SORTED_ORDER || otherIsTiny))
+    {
+        const int* otherSorted = otherIntSet.data;
+        int* scratch = NULL;
+        if(otherIntSet.ordering != SORTED_ORDER) // Cheap, since it is tiny.
+            otherSorted = scratch = otherIntSet.sortedCopy();
+        used = sortedIntersect(data, used, otherSorted, otherSize, data);
+        otherIntSet.deleteInts(scratch, otherSize);
+        refingerprint();
+        return;
+    }
+
+    if(otherIsTiny) // Gather the few values found, in the order of *this.
+    {
+        int* positions = newInts(otherSize);
+        int found = 0;
+        for(int j = 0; j < otherIntSet.used; j++)
+        {
+            if(otherIntSet.tombstoneAt(j))
+                continue;
+            int position = find(otherIntSet.data[j]);
+            if(position != -1)
+                positions[found++] = position;
+        }
+        sort(positions, positions + found);
+        for(int k = 0; k < found; k++) // positions[k] >= k, so nothing is
+            data[k] = data[positions[k]]; // overwritten before it is read.
+        used = found;
+        deleteInts(positions, otherSize);
+    }
+    else
+    {
+        int kept = 0;
+        for(int i = 0; i < used; i++) // Slide the values in both sets
+        {                             // down over the others.
+            if(otherIntSet.contains(data[i]))
+                data[kept++] = data[i];
+        }
+        used = kept;
+    }
+    reindex();
+    refingerprint();
+}
+
+void IntSet::subtractInPlace(const IntSet& otherIntSet)
+{
+    if(&otherIntSet == this) // Everything goes.
+    {
+        reset();
+        return;
+    }
+
+    detach();
+    compact();
+    int otherSize = otherIntSet.size();
+    bool otherIsTiny = double(otherSize) * GALLOP_RATIO < used;
+
+    if(ordering == SORTED_ORDER &&
+       (otherIntSet.ordering == SORTED_ORDER || otherIsTiny))
+    {
+        const int* otherSorted = otherIntSet.data;
+        int* scratch = NULL;
+        if(otherIntSet.ordering != SORTED_ORDER) // Cheap, since it is tiny.
+            otherSorted = scratch = otherIntSet.sortedCopy();
+        used = sortedDifference(data, used, otherSorted, otherSize, data);
+        otherIntSet.deleteInts(scratch, otherSize);
+        refingerprint();
+        return;
+    }
+
+    if(otherIsTiny) // Close up the few gaps left by otherIntSet's values.
+    {
+        int* positions = newInts(otherSize + 1);
+        int found = 0;
+        for(int j = 0; j < otherIntSet.used; j++)
+        {
+            if(otherIntSet.tombstoneAt(j))
+                continue;
+            int position = find(otherIntSet.data[j]);
+            if(position != -1)
+                positions[found++] = position;
+        }
+        sort(positions, positions + found);
+        positions[found] = used; // Sentinel ending the last run.
+        int kept = positions[0]; // The first run stays where it is.
+        for(int k = 0; k < found; k++)
+        {
+            for(int i = positions[k] + 1; i < positions[k + 1]; i++)
+                data[kept++] = data[i];
+        }
+        used = kept;
+        deleteInts(positions, otherSize + 1);
+    }
+    else
+    {
+        int kept = 0;
+        for(int i = 0; i < used; i++) // Slide the values otherIntSet
+        {                             // lacks down over the others.
+            if(otherIntSet.contains(data[i]) == false)
+                data[kept++] = data[i];
+        }
+        used = kept;
+    }
+    reindex();
+    refingerprint();
+}
+
+namespace
+{
+    // Writes the ascending symmetric difference of a[0..na) and
+    // b[0..nb) (each strictly ascending) to out, and returns its
+    // size. Only the result is written, one int at a time, so out
+    // may be scratch of exactly that size, or may start at or below a
+    // in the same array (it never overtakes the ints of a still to
+    // be read).
+    int mergeSymmetricDifferenceDown(const int* a, int na, const int* b,
+                                     int nb, int* out)
+    {
+        int i = 0, j = 0, k = 0;
+        while(i < na && j < nb)
+        {
+            if(a[i] < b[j])
+                out[k++] = a[i++];
+            else if(b[j] < a[i])
+                out[k++] = b[j++];
+            else
+            {
+                i++;
+                j++;
+            }
+        }
+        while(i < na)
+            out[k++] = a[i++];
+        while(j < nb)
+            out[k++] = b[j++];
+        return k;
+    }
+}
+
+void IntSet::symmetricDifferenceInPlace(const IntSet& otherIntSet)
+{
+    if(&otherIntSet == this) // Everything is in both.
+    {
+        reset();
+        return;
+    }
+
+    detach();
+    compact();
+    int otherSize = otherIntSet.size();
+
+    if(ordering == SORTED_ORDER)
+    {
+        if(otherSize == 0)
+            return;
+        int small[INLINE_CAPACITY];
+        int* scratch;
+        const int* otherSorted = otherIntSet.sortedData(small, scratch);
+        bool serial = workersFor(used + otherSize) == 1;
+        if(serial && used + otherSize <= capacity)
+        {   // Move data's values up by otherSize, then merge down from
+            // there into the front of data.
+            for(int i = used - 1; i >= 0; i--)
+                data[otherSize + i] = data[i];
+            used = mergeSymmetricDifferenceDown(data + otherSize, used,
+                                                otherSorted, otherSize,
+                                                data);
+        }
+        else
+        {   // As for unionInPlace: an array of the exact size.
+            int n = used + otherSize - 2 *
+                    sortedIntersectionSize(data, used, otherSorted,
+                                           otherSize);
+            int result[INLINE_CAPACITY];
+            int* merged = n <= INLINE_CAPACITY ? result : newInts(n);
+            if(serial)
+                mergeSymmetricDifferenceDown(data, used, otherSorted,
+                                             otherSize, merged);
+            else
+                combineSorted(SYMMETRIC_DIFFERENCE_OP, data, used,
+                              otherSorted, otherSize, merged);
+            adoptData(merged, n);
+        }
+        otherIntSet.deleteInts(scratch, otherSize);
+        refingerprint();
+        return;
+    }
+
+    if(capacity < used + otherSize) // Grow once, to the most the result
+        resize(used + otherSize);   // can hold.
+    int added = 0;
+    for(int i = 0; i < otherIntSet.used; i++)
+    {   // otherIntSet's own values go after used for now (as in
+        // unionInPlace, find() only sees the original values).
+        if(!otherIntSet.tombstoneAt(i) && find(otherIntSet.data[i]) == -1)
+            data[used + added++] = otherIntSet.data[i];
+    }
+    int kept = 0;
+    for(int i = 0; i < used; i++) // Drop the values common to both...
+    {
+        if(otherIntSet.contains(data[i]) == false)
+            data[kept++] = data[i];
+    }
+    for(int i = 0; i < added; i++) // ...and close up behind what is left.
+        data[kept + i] = data[used + i];
+    used = kept + added;
+    reindex();
+    refingerprint();
+}
+
+IntSet IntSet::unionWith(const IntSet& otherIntSet) &&
+{
+    unionInPlace(otherIntSet);
+    return std::move(*this);
+}
+
+IntSet IntSet::intersect(const IntSet& otherIntSet) &&
+{
+    intersectInPlace(otherIntSet);
+    return std::move(*this);
+}
+
+IntSet IntSet::subtract(const IntSet& otherIntSet) &&
+{
+    subtractInPlace(otherIntSet);
+    return std::move(*this);
+}
+
+IntSet IntSet::intersectAll(const IntSet* const* sets, int count)
+{
+    if(count <= 0)
+        return IntSet();
+    const IntSet& first = *sets[0];
+
+    int* bySize = first.newInts(count); // Smallest first, so the
+    for(int i = 0; i < count; i++)      // candidates thin out fastest.
+        bySize[i] = i;
+    sort(bySize, bySize + count, [sets](int x, int y)
+         { return sets[x]->size() < sets[y]->size(); });
+
+    const IntSet& smallest = *sets[bySize[0]];
+    int candidates = smallest.size(); // The smallest set's values.
+    int* kept = first.newInts(candidates);
+    int n = smallest.copyLive(kept);
+    for(int s = 1; s < count && n > 0; s++) // Stop once none are left.
+    {
+        const IntSet& next = *sets[bySize[s]];
+        if(&next == &smallest)
+            continue;
+        int m = 0;
+        for(int i = 0; i < n; i++)
+        {
+            if(next.contains(kept[i]))
+                kept[m++] = kept[i];
+        }
+        n = m;
+    }
+
+    IntSet result(n, first.memory); // Written once, in the order of
+    result.ordering = first.ordering; // first (as chained intersects).
+    if(&smallest != &first && n > 0)
+    {
+        if(first.ordering == SORTED_ORDER)
+            sort(kept, kept + n);
+        else
+        {
+            for(int i = 0; i < n; i++)
+                kept[i] = first.find(kept[i]);
+            sort(kept, kept + n);
+            for(int i = 0; i < n; i++)
+                kept[i] = first.data[kept[i]];
+        }
+    }
+    for(int i = 0; i < n; i++)
+        result.data[i] = kept[i];
+    result.used = n;
+    result.reindex();
+    result.refingerprint();
+
+    first.deleteInts(kept, candidates);
+    first.deleteInts(bySize, count);
+    return result;
+}
+
+IntSet IntSet::intersectAll(initializer_list<const IntSet*> sets)
+{
+    return intersectAll(sets.begin(), int(sets.size()));
+}
+
+IntSet IntSet::unionAll(const IntSet* const* sets, int count)
+{
+    if(count <= 0)
+        return IntSet();
+    const IntSet& first = *sets[0];
+
+    long long total = 0; // May pass INT_MAX, though the union may not.
+    int largest = 0;
+    for(int i = 0; i < count; i++)
+    {
+        total += sets[i]->size();
+        largest = max(largest, sets[i]->size());
+    }
+    // The union holds at least the largest set and at most all of
+    // them: start with room for twice the largest (if the sets have
+    // that many between them), and grow only if it runs out.
+    IntSet result(int(min(total, 2LL * largest)), first.memory);
+    result.ordering = first.ordering;
+
+    if(first.ordering == INSERTION_ORDER)
+    {   // Every set's values in turn, as chained unionWiths would add
+        // them, dropping repeats (see addPending) whenever the next set
+        // does not fit after those gathered so far.
+        int pending = 0;
+        for(int i = 0; i < count; i++)
+        {
+            long long needed = (long long)result.used + pending +
+                               sets[i]->size();
+            if(needed > result.capacity)
+            {
+                result.addPending(pending);
+                pending = 0;
+                needed = (long long)result.used + sets[i]->size();
+                if(needed > result.capacity)
+                    result.resize(int(min((long long)INT_MAX,
+                        max(needed, 2LL * result.capacity))));
+            }
+            pending += sets[i]->copyLive(result.data + result.used +
+                                         pending);
+        }
+        result.addPending(pending);
+        result.shrinkToFit();
+        return result;
+    }
+
+    // SORTED_ORDER: a k-way merge, taking the smallest head of all the
+    // sets from a heap each time, and skipping repeats as they come.
+    const int** run = static_cast<const int**>(first.memory->allocate(
+        sizeof(const int*) * count, alignof(const int*)));
+    int* at = first.newInts(3 * count); // at[i]: next of run[i];
+    int* end = at + count;              // end[i]: run[i]'s length;
+    int* heap = end + count;            // heap: runs not yet used up.
+    int live = 0;
+    for(int i = 0; i < count; i++)
+    {
+        run[i] = sets[i]->ordering == SORTED_ORDER ? sets[i]->data
+                                                   : sets[i]->sortedCopy();
+        at[i] = 0;
+        end[i] = sets[i]->size();
+        if(end[i] > 0)
+            heap[live++] = i;
+    }
+    auto later = [run, at](int x, int y) // Min-heap on each run's head.
+                 { return run[x][at[x]] > run[y][at[y]]; };
+    make_heap(heap, heap + live, later);
+
+    int k = 0;
+    while(live > 0)
+    {
+        pop_heap(heap, heap + live, later);
+        int i = heap[live - 1];
+        int value = run[i][at[i]++];
+        if(k == 0 || result.data[k - 1] != value)
+        {
+            if(k == result.capacity)
+            {   // Out of room: grow, keeping the k merged so far.
+                result.used = k;
+                result.resize(int(min((long long)INT_MAX,
+                                      2LL * result.capacity)));
+            }
+            result.data[k++] = value;
+        }
+        if(at[i] < end[i])
+            push_heap(heap, heap + live, later);
+        else
+            live--;
+    }
+    result.used = k;
+    result.shrinkToFit(); // SORTED_ORDER: no index to rebuild.
+    result.refingerprint();
+
+    for(int i = 0; i < count; i++)
+    {
+        if(sets[i]->ordering != SORTED_ORDER)
+            sets[i]->deleteInts(const_cast<int*>(run[i]), end[i]);
+    }
+    first.deleteInts(at, 3 * count);
+    first.memory->deallocate(run, sizeof(const int*) * count,
+                             alignof(const int*));
+    return result;
+}
+
+IntSet IntSet::unionAll(initializer_list<const IntSet*> sets)
+{
+    return unionAll(sets.begin(), int(sets.size()));
+}
+
+IntSet& IntSet::operator|=(const IntSet& otherIntSet)
+{
+    unionInPlace(otherIntSet);
+    return *this;
+}
+
+IntSet& IntSet::operator&=(const IntSet& otherIntSet)
+{
+    intersectInPlace(otherIntSet);
+    return *this;
+}
+
+IntSet& IntSet::operator-=(const IntSet& otherIntSet)
+{
+    subtractInPlace(otherIntSet);
+    return *this;
+}
+
+IntSet& IntSet::operator^=(const IntSet& otherIntSet)
+{
+    symmetricDifferenceInPlace(otherIntSet);
+    return *this;
+}
+
+void IntSet::reset()
+{
+    if(shared.load(memory_order_relaxed) != NULL)
+    {   // Nothing is worth copying: just stop sharing.
+        releaseArrays();
+        data = inlineData;
+        capacity = INLINE_CAPACITY;
+        index = NULL;
+        shared.store(NULL, memory_order_relaxed);
+    }
+    else
+        deleteDead();
+    used = 0;
+    tombstones = 0;
+    hashSum = 0;
+    reindex(); // An empty IntSet goes back to being scanned.
+}
+
+bool IntSet::add(int anInt)
+{
+    if(ordering == SORTED_ORDER)
+    {
+        int at = int(lower_bound(data, data + used, anInt) - data);
+        if(at < used && data[at] == anInt)
+            return false;
+
+        detach();
+        if(used >= capacity)
+            grow();
+        for(int j = used; j > at; j--) // Open a gap at anInt's place
+            data[j] = data[j - 1];     // in the ascending order.
+        data[at] = anInt;
+        used++;
+        hashSum += fingerprintOf(anInt);
+        return true;
+    }
+
+    if(find(anInt) == -1)
+    {
+        detach();
+        if(used >= capacity && tombstones > 0) // Reclaim the slots held by
+            compact();                         // tombstones before growing.
+        if(used >= capacity)     // If the size is at capacity, resize
+            grow();              // the entire array in grow().
+
+        data[used] = anInt;
+        used++; // Increment the used index to supplement the value added.
+        hashSum += fingerprintOf(anInt);
+        noteOperation(adds);
+
+        if(layout != SCANNED && indexCovers(anInt))
+            indexInsert(used - 1);
+        else if(layout != SCANNED || used > LINEAR_SCAN_LIMIT)
+        {
+            used--;    // Hold anInt back while compacting, as the old
+            compact(); // (DIRECT) index may have no slot for it...
+            data[used] = anInt;
+            used++;
+            reindex(); // ...then grow (or first build) the index for
+        }              // a dense array, picking its layout afresh.
+        return true;
+    }
+    return false;
+}
+
+bool IntSet::remove(int anInt)
+{
+    int position = find(anInt); // find() hands back the index directly.
+    if(position == -1)
+        return false;
+
+    detach();
+    hashSum -= fingerprintOf(anInt);
+    noteOperation(removes);
+    if(layout == SCANNED) // Few enough values (or SORTED_ORDER, which has
+                          // no index) that shifting is what is done.
+    {
+        for(int j = position; j < used - 1; j++) // Move every element after anInt
+            data[j] = data[j + 1];               // back one index.
+        used--;
+        return true;
+    }
+
+    indexErase(position);
+    if(position == used - 1) // The last slot can simply be given back.
+        used--;
+    else
+    {
+        if(dead == NULL) // First tombstone since data was (re)allocated.
+        {
+            int words = (capacity + 31) / 32;
+            dead = static_cast<unsigned*>(
+                memory->allocate(sizeof(unsigned) * words, alignof(unsigned)));
+            for(int i = 0; i < words; i++)
+                dead[i] = 0;
+        }
+        dead[position / 32] |= 1U << (position % 32); // Leave a tombstone
+        tombstones++;                                 // instead of shifting.
+
+        if(2 * tombstones > used) // Compacting once tombstones are the
+            compact();            // majority keeps removal amortized O(1).
+    }
+
+    if(layout != SCANNED && size() <= LINEAR_SCAN_LIMIT / 2 && !churning())
+    {            // Small again, and not about to grow back: a scan
+        compact(); // beats keeping the index up.
+        reindex();
+    }
+    return true;
+}
+
+void IntSet::setOrder(Order newOrder)
+{
+    if(newOrder == ordering)
+        return;
+
+    detach();
+    compact();
+    ordering = newOrder;
+    if(ordering == SORTED_ORDER)
+        sort(data, data + used);
+    deleteDead(); // Neither order has tombstones right now.
+    reindex(); // Drops the index for SORTED_ORDER, builds it otherwise.
+}
+
+int IntSet::addAll(const int* values, int n)
+{
+    if(n <= 0)
+        return 0;
+    detach();
+    compact(); // Pending ints go right after the relevant values...
+    reserve(used + n); // ...which takes at most this one allocation.
+    for(int i = 0; i < n; i++)
+        data[used + i] = values[i];
+    return addPending(n);
+}
+
+int IntSet::addAll(initializer_list<int> values)
+{
+    return addAll(values.begin(), int(values.size()));
+}
+
+int IntSet::addPending(int n)
+{
+    int* pending = data + used;
+
+    if(ordering == SORTED_ORDER)
+    {
+        int m = 0;
+        for(int i = 0; i < n; i++) // Weed out what is there already...
+        {
+            if(binary_search(data, data + used, pending[i]) == false)
+                pending[m++] = pending[i];
+        }
+        sort(pending, pending + m); // ...and repeats among the rest.
+        m = int(unique(pending, pending + m) - pending);
+
+        for(int i = 0; i < m; i++)
+            hashSum += fingerprintOf(pending[i]);
+        if(used > 0) // Nothing to merge with when bulk loading an
+            inplace_merge(data, pending, pending + m); // empty IntSet.
+        used += m;
+        return m;
+    }
+
+    int kept = used;
+    if(n <= LINEAR_SCAN_LIMIT) // Few enough that scanning the ints kept
+    {                          // so far beats a scratch table.
+        for(int i = used; i < used + n; i++)
+        {
+            int value = data[i];
+            if(find(value) == -1 &&
+               scanFind(data + used, kept - used, value) == -1)
+                data[kept++] = value;
+        }
+    }
+    else
+    {
+        int slots = 1; // Scratch table of positions of the ints kept,
+        while(slots < 2 * n) // at most half full.
+            slots *= 2;
+        unsigned mask = unsigned(slots - 1);
+        int* seen = newInts(slots);
+        for(int i = 0; i < slots; i++)
+            seen[i] = -1;
+
+        for(int i = used; i < used + n; i++)
+        {
+            int value = data[i];
+            if(find(value) != -1) // find() only looks at data[0..used).
+                continue;
+            unsigned slot = hashOf(value) & mask;
+            while(seen[slot] != -1 && data[seen[slot]] != value)
+                slot = (slot + 1) & mask;
+            if(seen[slot] == -1) // First occurrence: slide it down to
+            {                    // the end of the ints kept so far.
+                data[kept] = value;
+                seen[slot] = kept++;
+            }
+        }
+        deleteInts(seen, slots);
+    }
+
+    int added = kept - used;
+    if(added > 0)
+    {
+        for(int i = used; i < kept; i++)
+            hashSum += fingerprintOf(data[i]);
+        used = kept;
+        if(layout != SCANNED || used > LINEAR_SCAN_LIMIT)
+            reindex();
+    }
+    return added;
+}
+
+void IntSet::reserve(int n)
+{
+    if(n > capacity) // Never shrinks (see shrinkToFit).
+    {
+        detach();
+        resize(n);
+    }
+}
+
+void IntSet::shrinkToFit()
+{
+    detach();
+    resize(size()); // Squeezes out tombstones, then fits data to used.
+    if(layout != SCANNED)
+        reindex(); // Fits the index to what is left, too.
+}
+
+void IntSet::setGrowthPolicy(GrowthPolicy policy)
+{
+    growth = policy != NULL ? policy : growGeometric;
+}
+
+IntSet::GrowthPolicy IntSet::growthPolicy() const
+{
+    return growth;
+}
+
+MemoryResource* IntSet::memoryResource() const
+{
+    return memory;
+}
+
+unsigned long long IntSet::fingerprint() const
+{
+    return hashSum;
+}
+
+IntSet::LayoutStats IntSet::layoutStats()
+{
+    LayoutStats stats;
+    stats.toScanned = switchesToScanned.load(memory_order_relaxed);
+    stats.toHashed = switchesToHashed.load(memory_order_relaxed);
+    stats.toDirect = switchesToDirect.load(memory_order_relaxed);
+    return stats;
+}
+
+void IntSet::resetLayoutStats()
+{
+    switchesToScanned.store(0, memory_order_relaxed);
+    switchesToHashed.store(0, memory_order_relaxed);
+    switchesToDirect.store(0, memory_order_relaxed);
+}
+
+void IntSet::setParallelism(int threads, int cutoff)
+{
+    threadSetting.store(threads > 0 ? threads : 0, memory_order_relaxed);
+    cutoffSetting.store(cutoff, memory_order_relaxed);
+}
+
+int IntSet::parallelThreads()
+{
+    int threads = threadSetting.load(memory_order_relaxed);
+    if(threads > 0)
+        return threads;
+    threads = int(thread::hardware_concurrency()); // 0 if unknown.
+    return threads > 0 ? threads : 1;
+}
+
+int IntSet::parallelCutoff()
+{
+    return cutoffSetting.load(memory_order_relaxed);
+}
+
+bool operator==(const IntSet& is1, const IntSet& is2)
+{
+    if(is1.size()!=is2.size()) // if they are not the same size,
+        return false;          // they can not be logically equal.
+    if(is1.fingerprint() != is2.fingerprint()) // Different elements (the
+        return false;          // fingerprints of equal sets always match).
+
+    // Same size, so one being a subset of the other makes them equal.
+    return is1.isSubsetOf(is2);
 }
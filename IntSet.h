@@ -10,15 +10,90 @@
 //     values "an IntSet created by the default constructor"
 //     can accommodate).
 //
+//   static const int INLINE_CAPACITY = ____
+//     IntSet::INLINE_CAPACITY is the # of values an IntSet can hold
+//     in storage inside the IntSet object itself; only an IntSet
+//     that outgrows it allocates its array dynamically. So the many
+//     small IntSets a program typically has are created, copied and
+//     destroyed without any dynamic allocation at all.
+//   static const int GROWTH_STEP = ____
+//     IntSet::GROWTH_STEP is the # of slots IntSet::growFixedStep
+//     adds to the capacity each time an IntSet using it grows.
+//   static const int PARALLEL_CUTOFF = ____
+//     IntSet::PARALLEL_CUTOFF is the default # of elements (both
+//     operands together) below which a set operation runs on the
+//     calling thread alone (see setParallelism).
+//
+// TYPE
+//   enum Order { INSERTION_ORDER, SORTED_ORDER }
+//     The order in which an IntSet keeps (and DumpData writes) its
+//     elements. INSERTION_ORDER (the default) keeps them in order of
+//     membership; SORTED_ORDER keeps them in ascending order, which
+//     makes unionWith, intersect and subtract linear-time merges
+//     at the cost of add/remove shifting later elements.
+//   typedef int (*GrowthPolicy)(int current_capacity)
+//     A rule for how far an IntSet grows when an add finds it full:
+//     given the current capacity, it returns the next one. Any
+//     function of this type can be used (see setGrowthPolicy); the
+//     built-in rules are IntSet::growGeometric (the default),
+//     IntSet::growDoubling and IntSet::growFixedStep. A rule should
+//     saturate at INT_MAX rather than overflow, as the built-in ones
+//     do; a result not above the size (a negative one included) is
+//     taken as one more than the size.
+//   struct LayoutStats { long toScanned; long toHashed; long toDirect; }
+//     How many times (process-wide) an IntSet has switched the way it
+//     looks up its elements: to a plain scan (small IntSets, and all
+//     IntSets in SORTED_ORDER), to a hash table (large IntSets whose
+//     elements are spread out), or to a direct-address table (large
+//     IntSets whose elements are densely packed, e.g. IDs handed out
+//     in sequence). The choice is made from the size and the range
+//     of the elements, and from the recent mix of adds and removes,
+//     whenever the lookup structure has to be rebuilt anyway; it
+//     never changes what any member function returns.
+//   enum Encoding { RAW_ENCODING, DELTA_VARINT_ENCODING }
+//     How serialize writes the elements: RAW_ENCODING as 4 bytes
+//     each; DELTA_VARINT_ENCODING as the difference from the element
+//     before, zigzag-coded and written 7 bits to a byte (so the
+//     closer together successive elements are, the fewer bytes each
+//     takes: 1 byte for differences up to 63 either way).
+//
 // CONSTRUCTOR
-//   IntSet(int initial_capacity = DEFAULT_CAPACITY)
+//   IntSet(int initial_capacity = DEFAULT_CAPACITY,
+//          MemoryResource* resource = NULL)
+//     Pre:  resource, if not NULL, outlives the IntSet (and any
+//           IntSet moved from it, see VALUE SEMANTICS).
 //     Post: The invoking IntSet is initialized to an empty
 //           IntSet (i.e., one containing no relevant elements);
 //           the initial capacity is given by initial_capacity if
 //           initial_capacity is >= 1, otherwise it is given by
-//           IntSet:DEFAULT_CAPACITY.
+//           IntSet:DEFAULT_CAPACITY. All of its arrays are allocated
+//           from resource (newDeleteResource() if resource is NULL;
+//           see MemoryResource.h), as are those of the IntSets that
+//           unionWith, intersect and subtract return from it.
+//     Note: The capacity is never less than INLINE_CAPACITY.
 //     Note: When the IntSet is put to use after construction,
 //           its capacity will be resized as necessary.
+//   IntSet(const int* values, int n, MemoryResource* resource = NULL)
+//   IntSet(std::initializer_list<int> values,
+//          MemoryResource* resource = NULL)
+//   template <class ForwardIterator>
+//   IntSet(ForwardIterator first, ForwardIterator last,
+//          MemoryResource* resource = NULL)
+//     Pre:  values references (at least) n ints, or [first, last) is
+//           a range of ints (any forward iterator will do); resource
+//           is as for the constructor above.
+//     Post: The invoking IntSet is initialized to hold the distinct
+//           ints given, in the order they first occur (see addAll),
+//           allocating from resource as above.
+//     Note: The array is allocated once, at the number of ints
+//           given, whatever the number of repeats among them.
+//   IntSet(const IntSet& src, MemoryResource* resource)
+//     Pre:  resource is as for the first constructor.
+//     Post: The invoking IntSet is initialized to a copy of src (its
+//           elements, order, order() and growth policy) that
+//           allocates from resource (newDeleteResource() if resource
+//           is NULL). The plain copy constructor is the same with a
+//           NULL resource (see VALUE SEMANTICS).
 //
 // CONSTANT MEMBER FUNCTIONS (ACCESSORS)
 //   int size() const
@@ -32,6 +107,24 @@
 //     Pre:  (none)
 //     Post: true is returned if the invoking IntSet has anInt as an
 //           element, otherwise false is returned.
+//   Order order() const
+//     Pre:  (none)
+//     Post: The order the invoking IntSet keeps its elements in is
+//           returned.
+//   GrowthPolicy growthPolicy() const
+//     Pre:  (none)
+//     Post: The growth policy of the invoking IntSet is returned.
+//   MemoryResource* memoryResource() const
+//     Pre:  (none)
+//     Post: The MemoryResource the invoking IntSet allocates its
+//           arrays from is returned.
+//   unsigned long long fingerprint() const
+//     Pre:  (none)
+//     Post: An order-independent hash of the elements of the invoking
+//           IntSet is returned: equal IntSets (see operator==) always
+//           have the same fingerprint, and unequal ones almost never.
+//     Note: Kept up to date as elements come and go (add, remove,
+//           reset, the set operations), so this takes O(1) time.
 //   bool isSubsetOf(const IntSet& otherIntSet) const
 //     Pre:  (none)
 //     Post: True is returned if all elements of the invoking IntSet
@@ -40,12 +133,61 @@
 //           By definition, true is returned if the invoking IntSet
 //           is empty (i.e., an empty IntSet is always isSubsetOf
 //           another IntSet, even if the other IntSet is also empty).
+//   int intersectionSize(const IntSet& otherIntSet) const
+//   int unionSize(const IntSet& otherIntSet) const
+//   int differenceSize(const IntSet& otherIntSet) const
+//     Pre:  (none)
+//     Post: The size() of intersect(otherIntSet), unionWith(
+//           otherIntSet) or subtract(otherIntSet) is returned.
+//     Note: The result is counted, never built: nothing is
+//           allocated. When both IntSets are in SORTED_ORDER they are
+//           merged (or galloped through, see SetKernels.h) without
+//           writing anything; otherwise each element of the smaller
+//           IntSet is looked up in the larger.
+//   double jaccard(const IntSet& otherIntSet) const
+//     Pre:  (none)
+//     Post: The Jaccard similarity of the invoking IntSet and
+//           otherIntSet (intersectionSize / unionSize) is returned;
+//           1.0 if both are empty.
+//   bool intersects(const IntSet& otherIntSet) const
+//     Pre:  (none)
+//     Post: true is returned if the invoking IntSet and otherIntSet
+//           have at least one element in common, otherwise false.
+//     Note: Stops at the first element found in common; nothing is
+//           allocated.
 //   void DumpData(std::ostream& out) const
 //     Pre:  (none)
 //     Post: Contents of the invoking IntSet have been inserted into
 //           out with 2 spaces separating one item from another if
 //           if there are 2 or more items.
-//   IntSet unionWith(const IntSet& otherIntSet) const
+//     Note: Items are inserted in the order given by order().
+//   void dumpFast(std::ostream& out) const
+//     Pre:  (none)
+//     Post: Same as DumpData.
+//     Note: Unless out has been told to format ints some other way
+//           (another base, showpos, a field width, or a locale that
+//           groups digits), IntSet formats them itself into a large
+//           buffer and writes it to out in big chunks, many times
+//           faster than inserting them one by one; the characters
+//           written are the same either way.
+//   void serialize(std::ostream& out,
+//                  Encoding encoding = DELTA_VARINT_ENCODING) const
+//     Pre:  out is open in binary mode.
+//     Post: The invoking IntSet (its elements, in order, and its
+//           order()) has been written to out in the binary format
+//           deserialize reads: a 16-byte header (the magic bytes
+//           "ISET", a format version, flags for the encoding and the
+//           order, the # of elements and the # of bytes of payload),
+//           the elements encoded as given, and a 4-byte checksum
+//           (FNV-1a) of everything before it. All multi-byte fields
+//           are little-endian, whatever the machine.
+//     Note: If writing fails, out's state says so (as for DumpData).
+//           The header holds the # of bytes of payload in 32 bits, so
+//           an IntSet whose payload would need more (2^30 elements or
+//           more with RAW_ENCODING, or over 4 GB of varint bytes) is
+//           not written at all: out's badbit is set instead.
+//   IntSet unionWith(const IntSet& otherIntSet) const &
+//   IntSet unionWith(const IntSet& otherIntSet) &&
 //     Pre:  (none)
 //     Post: An IntSet representing the union of the invoking IntSet
 //           and otherIntSet is returned.
@@ -53,7 +195,13 @@
 //           returned is one that initially is an exact copy of the
 //           invoking IntSet but subsequently has all elements of
 //           otherIntSet added.
-//   IntSet intersect(const IntSet& otherIntSet) const
+//     Note: The IntSet returned has the same order() as the invoking
+//           IntSet. When that is SORTED_ORDER, it is produced by a
+//           single merge pass over both IntSets (otherIntSet's
+//           elements are sorted into a temporary array first if it
+//           is kept in INSERTION_ORDER).
+//   IntSet intersect(const IntSet& otherIntSet) const &
+//   IntSet intersect(const IntSet& otherIntSet) &&
 //     Pre:  (none)
 //     Post: An IntSet representing the intersection of the invoking
 //           IntSet and otherIntSet is returned.
@@ -61,7 +209,11 @@
 //           returned is one that initially is an exact copy of the
 //           invoking IntSet but subsequently has all of its elements
 //           that are not also elements of otherIntSet removed.
-//   IntSet subtract(const IntSet& otherIntSet) const
+//     Note: As for unionWith, the IntSet returned has the same
+//           order() as the invoking IntSet and is merged in a single
+//           pass when that is SORTED_ORDER.
+//   IntSet subtract(const IntSet& otherIntSet) const &
+//   IntSet subtract(const IntSet& otherIntSet) &&
 //     Pre:  (none)
 //     Post: An IntSet representing the difference between the invoking
 //           IntSet and otherIntSet is returned.
@@ -69,6 +221,27 @@
 //           returned is one that initially is an exact copy of the
 //           invoking IntSet but subsequently has all elements of
 //           otherIntSet removed.
+//     Note: As for unionWith, the IntSet returned has the same
+//           order() as the invoking IntSet and is merged in a single
+//           pass when that is SORTED_ORDER.
+//   NOTE: The && versions of unionWith, intersect and subtract are
+//         picked when the invoking IntSet is a temporary (such as
+//         the IntSet returned by another set operation). They work
+//         in the temporary's own array (see unionInPlace and the
+//         like) and move it into the IntSet returned, so a chain
+//         like a.unionWith(b).intersect(c) allocates only for its
+//         first step.
+//   NOTE: When the two IntSets hold at least parallelCutoff()
+//         elements between them, unionWith, intersect and subtract
+//         (and unionInPlace and symmetricDifferenceInPlace in
+//         SORTED_ORDER) split the work over parallelThreads()
+//         threads. In SORTED_ORDER both arrays are cut into ranges
+//         at the same pivot values; otherwise the elements being
+//         tested are cut into ranges of positions. Each thread first
+//         counts how many ints its range yields, and then writes
+//         them straight into the result at the offset the counts
+//         before it add up to, so the result is exactly the one the
+//         calling thread alone would produce.
 //
 // MODIFICATION MEMBER FUNCTIONS (MUTATORS)
 //   void reset()
@@ -87,6 +260,188 @@
 //           removed from the invoking IntSet and true is
 //           returned, otherwise the invoking IntSet is unchanged
 //           and false is returned.
+//   void setOrder(Order newOrder)
+//     Pre:  (none)
+//     Post: The invoking IntSet keeps its elements in newOrder from
+//           now on. Switching to SORTED_ORDER sorts the existing
+//           elements; switching to INSERTION_ORDER treats their
+//           current order as their order of membership.
+//   int addAll(const int* values, int n)
+//   int addAll(std::initializer_list<int> values)
+//   template <class ForwardIterator>
+//   int addAll(ForwardIterator first, ForwardIterator last)
+//     Pre:  As for the constructors of the same form.
+//     Post: Every int given has been added to the invoking IntSet as
+//           if by add, one after another, and the # of elements
+//           that were new to it is returned.
+//     Note: Unlike a loop of adds, the ints are copied into data in
+//           one go (growing it at most once) and weeded of repeats
+//           in a single hash pass (a single sort for SORTED_ORDER),
+//           after which the index is rebuilt just once.
+//   void reserve(int n)
+//     Pre:  (none)
+//     Post: The capacity of the invoking IntSet is at least n, so
+//           that it can hold n elements without growing again. The
+//           elements are unchanged.
+//   void shrinkToFit()
+//     Pre:  (none)
+//     Post: The capacity of the invoking IntSet is reduced to its
+//           size() (or DEFAULT_CAPACITY, if it is empty), giving
+//           back any slack. The elements are unchanged.
+//   void setGrowthPolicy(GrowthPolicy policy)
+//     Pre:  (none)
+//     Post: From now on, whenever an add finds the invoking IntSet
+//           full, its capacity grows to policy(capacity) (or to one
+//           more than the size, if policy gives less than that). A
+//           NULL policy restores the default, growGeometric.
+//     Note: Copies of an IntSet (by copy or move) get its policy.
+//   void unionInPlace(const IntSet& otherIntSet)
+//   void intersectInPlace(const IntSet& otherIntSet)
+//   void subtractInPlace(const IntSet& otherIntSet)
+//     Pre:  (none)
+//     Post: The invoking IntSet has become what unionWith, intersect
+//           or subtract (respectively) would have returned for it
+//           and otherIntSet.
+//     Note: No IntSet is built along the way: the result is formed
+//           in the invoking IntSet's own array, which is grown at
+//           most once (to the size of both IntSets together, for
+//           unionInPlace). otherIntSet may be the invoking IntSet.
+//           In SORTED_ORDER, a union merges from the top of the
+//           array down when the result fits it; otherwise it goes
+//           into a new array of exactly the result's size (or into
+//           the IntSet itself, if that fits INLINE_CAPACITY).
+//   void symmetricDifferenceInPlace(const IntSet& otherIntSet)
+//     Pre:  (none)
+//     Post: The invoking IntSet has become the set of elements that
+//           are in exactly one of it and otherIntSet: its own such
+//           elements keep their order and otherIntSet's follow (in
+//           otherIntSet's order), or all are in ascending order if
+//           order() is SORTED_ORDER.
+//     Note: As for unionInPlace (in SORTED_ORDER, the merge runs in
+//           place when the array has room for both IntSets
+//           together).
+//   IntSet& operator|=(const IntSet& otherIntSet)
+//   IntSet& operator&=(const IntSet& otherIntSet)
+//   IntSet& operator-=(const IntSet& otherIntSet)
+//   IntSet& operator^=(const IntSet& otherIntSet)
+//     Pre:  (none)
+//     Post: Same as unionInPlace, intersectInPlace, subtractInPlace
+//           or symmetricDifferenceInPlace (respectively), and the
+//           invoking IntSet is returned.
+//   bool deserialize(std::istream& in)
+//     Pre:  in is open in binary mode, positioned at data written by
+//           serialize.
+//     Post: If a complete, well-formed IntSet (of a format version
+//           this IntSet can read, with a matching checksum and no
+//           repeated elements) was read from in, the invoking IntSet
+//           has been replaced by it (elements, order and order()) and
+//           true is returned. Otherwise false is returned, in's
+//           failbit is set, and the invoking IntSet is unchanged.
+//     Note: The elements are decoded straight into the new array,
+//           with no per-element add, and the index is then built in
+//           one pass. The array is not sized from the header's count
+//           up front (a corrupt count could ask for gigabytes): it
+//           starts at no more than 64K ints and doubles as elements
+//           arrive, so a bad count fails for want of bytes instead.
+//   bool loadFrom(std::istream& in)
+//     Pre:  (none)
+//     Post: If in had already failed (!in), nothing has been read,
+//           false is returned and the invoking IntSet is unchanged.
+//           Otherwise the rest of in has been read, to its end (past
+//           any malformed text too). If it held nothing but ints in
+//           decimal (each with an optional sign, and in range for
+//           int) separated by whitespace, as DumpData writes them,
+//           the invoking IntSet has been replaced by the set of those
+//           ints (kept in order of their first appearance, or
+//           ascending for SORTED_ORDER; order() is unchanged), in's
+//           eofbit is set and true is returned. Otherwise false is
+//           returned, in's failbit is set, and the invoking IntSet is
+//           unchanged.
+//     Note: Repeated ints are allowed; each is kept once. The text is
+//           parsed by IntSet itself, from large chunks of in's
+//           buffer, with no per-int operator>> or add: the ints are
+//           gathered straight into the new array, and repeats are
+//           weeded out in bulk (as for addAll) whenever it fills.
+//   bool loadFromFile(const char* path)
+//   bool loadFromFile(int fd)
+//     Pre:  (none)
+//     Post: As for loadFrom, with the text read from the file named
+//           path, or from the open file descriptor fd to its end (fd
+//           is left open); false is also returned if the file cannot
+//           be opened or read.
+//
+// STATIC MEMBER FUNCTIONS
+//   static LayoutStats layoutStats()
+//     Pre:  (none)
+//     Post: The layout switch counters (see LayoutStats) are
+//           returned.
+//     Note: Safe to call while other threads use (their own)
+//           IntSets.
+//   static void resetLayoutStats()
+//     Pre:  (none)
+//     Post: All layout switch counters are back to 0.
+//   static void setParallelism(int threads,
+//                              int cutoff = PARALLEL_CUTOFF)
+//     Pre:  (none)
+//     Post: Set operations from now on use up to threads threads (as
+//           many as the hardware runs at once if threads is 0 or
+//           less), on operands with at least cutoff elements between
+//           them (see the NOTE on set operations). threads == 1
+//           keeps every set operation on the calling thread.
+//   static int parallelThreads()
+//   static int parallelCutoff()
+//     Pre:  (none)
+//     Post: The # of threads and the cutoff set operations currently
+//           use is returned.
+//     Note: All three are safe to call while other threads use
+//           (their own) IntSets.
+//
+//   static IntSet intersectAll(const IntSet* const* sets, int count)
+//   static IntSet intersectAll(std::initializer_list<const IntSet*>
+//                              sets)
+//     Pre:  sets references (at least) count pointers to IntSets.
+//     Post: An IntSet representing the intersection of all the sets
+//           given is returned (an empty IntSet if there are none);
+//           it holds the same elements, in the same order() and
+//           order, as sets[0]->intersect(*sets[1]).intersect(...).
+//     Note: The candidates start out as the smallest set's elements,
+//           and are thinned by each of the other sets, smallest to
+//           largest, stopping as soon as none are left. Nothing is
+//           allocated along the way but one array of candidates;
+//           the result is written once, at its final size.
+//   static IntSet unionAll(const IntSet* const* sets, int count)
+//   static IntSet unionAll(std::initializer_list<const IntSet*> sets)
+//     Pre:  sets references (at least) count pointers to IntSets,
+//           whose union has at most INT_MAX elements (the sizes of
+//           the sets may add up to more).
+//     Post: An IntSet representing the union of all the sets given
+//           is returned (an empty IntSet if there are none); it
+//           holds the same elements, in the same order() and order,
+//           as sets[0]->unionWith(*sets[1]).unionWith(...), and its
+//           capacity is fitted to its size.
+//     Note: The result starts with room for twice the largest set
+//           (or the total size of the sets, if less) and grows only
+//           when that runs out. In SORTED_ORDER it is filled by one
+//           k-way merge of all the sets (their smallest heads kept in
+//           a heap); in INSERTION_ORDER the sets' elements are copied
+//           in and the repeats dropped in bulk (see addAll) whenever
+//           the next set does not fit.
+//     Note: The result of intersectAll and unionAll allocates from
+//           sets[0]'s MemoryResource.
+//
+//   static int growGeometric(int current_capacity)
+//     Pre:  current_capacity >= 0.
+//     Post: int(1.5 * current_capacity) + 1 is returned (INT_MAX if
+//           that is more than INT_MAX).
+//   static int growDoubling(int current_capacity)
+//     Pre:  current_capacity >= 0.
+//     Post: 2 * current_capacity is returned (DEFAULT_CAPACITY if
+//           current_capacity is 0, INT_MAX if it is more than
+//           INT_MAX / 2).
+//   static int growFixedStep(int current_capacity)
+//     Pre:  current_capacity >= 0.
+//     Post: current_capacity + GROWTH_STEP is returned (INT_MAX if
+//           that is more than INT_MAX).
 //
 // NON-MEMBER FUNCTIONS
 //   bool operator==(const IntSet& is1, const IntSet& is2)
@@ -95,43 +450,232 @@
 //           otherwise false is returned; for e.g.: {1,2,3}, {1,3,2},
 //           {2,1,3}, {2,3,1}, {3,1,2}, and {3,2,1} are all equal.
 //     Note: By definition, two empty IntSet's are equal.
+//     Note: IntSets of the same size but different fingerprints are
+//           told apart in O(1) time; only when those match too are
+//           the elements themselves compared (in linear time).
 //
 // VALUE SEMANTICS
 //   Assignment and the copy constructor may be used with IntSet
 //   objects.
+//   So may move assignment and the move constructor, which take over
+//   the source's arrays instead of copying them (and never throw, but
+//   see below for MemoryResources); the source is left an empty
+//   IntSet that is still fit for use.
+//   Copies of an IntSet too large for INLINE_CAPACITY take O(1) time
+//   (when both allocate from the same MemoryResource):
+//   the copy and the original share one array (copy-on-write) until
+//   either of them is changed, at which point the one being changed
+//   takes a copy of its own. Concurrent use of copies that share an
+//   array is as safe as it would be for separate IntSets.
+//   The const member functions (copying included) never change the
+//   IntSet they are called on, not even how it lays out its arrays,
+//   so any number of threads may call them on one IntSet at once (as
+//   long as no thread changes it meanwhile).
+//   The MemoryResource goes with an IntSet as std::pmr's allocators
+//   do with containers: a copy made by the copy constructor
+//   allocates from newDeleteResource() (give the copy constructor a
+//   resource for any other), and one made by the move constructor
+//   from the source's resource. Assignment never changes the
+//   resource the invoking IntSet allocates from: the source's
+//   elements are copied into that resource, and arrays are shared
+//   (by copy assignment) or taken over (by move assignment) only
+//   when the source allocates from the same resource. So move
+//   assignment between IntSets with different resources copies
+//   (leaving the source as it was) and may throw std::bad_alloc.
 
 #ifndef INT_SET_H
 #define INT_SET_H
 
 #include <iostream>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <atomic>
+#include "MemoryResource.h"
+
+struct IntSetShare; // Count of IntSets sharing arrays (see IntSet.cpp).
 
 class IntSet
 {
 public:
    static const int DEFAULT_CAPACITY = 1;
-   IntSet(int initial_capacity = DEFAULT_CAPACITY);
+   static const int INLINE_CAPACITY = 8;
+   static const int GROWTH_STEP = 4096;
+   static const int PARALLEL_CUTOFF = 1 << 20;
+   enum Order { INSERTION_ORDER, SORTED_ORDER };
+   typedef int (*GrowthPolicy)(int current_capacity);
+   struct LayoutStats { long toScanned; long toHashed; long toDirect; };
+   enum Encoding { RAW_ENCODING, DELTA_VARINT_ENCODING };
+   IntSet(int initial_capacity = DEFAULT_CAPACITY,
+          MemoryResource* resource = NULL);
+   IntSet(const int* values, int n, MemoryResource* resource = NULL);
+   IntSet(std::initializer_list<int> values,
+          MemoryResource* resource = NULL);
+   template <class ForwardIterator, class = typename std::enable_if<
+      std::is_base_of<std::forward_iterator_tag, typename
+         std::iterator_traits<ForwardIterator>::iterator_category>::value>::type>
+   IntSet(ForwardIterator first, ForwardIterator last,
+          MemoryResource* resource = NULL);
    IntSet(const IntSet& src);
+   IntSet(const IntSet& src, MemoryResource* resource);
+   IntSet(IntSet&& src) noexcept;
    ~IntSet();
    IntSet& operator=(const IntSet& rhs);
+   IntSet& operator=(IntSet&& rhs);
    int size() const;
    bool isEmpty() const;
    bool contains(int anInt) const;
+   Order order() const;
+   GrowthPolicy growthPolicy() const;
+   MemoryResource* memoryResource() const;
+   unsigned long long fingerprint() const;
    bool isSubsetOf(const IntSet& otherIntSet) const;
+   int intersectionSize(const IntSet& otherIntSet) const;
+   int unionSize(const IntSet& otherIntSet) const;
+   int differenceSize(const IntSet& otherIntSet) const;
+   double jaccard(const IntSet& otherIntSet) const;
+   bool intersects(const IntSet& otherIntSet) const;
    void DumpData(std::ostream& out) const;
-   IntSet unionWith(const IntSet& otherIntSet) const;
-   IntSet intersect(const IntSet& otherIntSet) const;
-   IntSet subtract(const IntSet& otherIntSet) const;
+   void dumpFast(std::ostream& out) const;
+   void serialize(std::ostream& out,
+                  Encoding encoding = DELTA_VARINT_ENCODING) const;
+   IntSet unionWith(const IntSet& otherIntSet) const &;
+   IntSet unionWith(const IntSet& otherIntSet) &&;
+   IntSet intersect(const IntSet& otherIntSet) const &;
+   IntSet intersect(const IntSet& otherIntSet) &&;
+   IntSet subtract(const IntSet& otherIntSet) const &;
+   IntSet subtract(const IntSet& otherIntSet) &&;
    void reset();
    bool add(int anInt);
    bool remove(int anInt);
+   void setOrder(Order newOrder);
+   int addAll(const int* values, int n);
+   int addAll(std::initializer_list<int> values);
+   template <class ForwardIterator, class = typename std::enable_if<
+      std::is_base_of<std::forward_iterator_tag, typename
+         std::iterator_traits<ForwardIterator>::iterator_category>::value>::type>
+   int addAll(ForwardIterator first, ForwardIterator last);
+   void reserve(int n);
+   void shrinkToFit();
+   void setGrowthPolicy(GrowthPolicy policy);
+   void unionInPlace(const IntSet& otherIntSet);
+   void intersectInPlace(const IntSet& otherIntSet);
+   void subtractInPlace(const IntSet& otherIntSet);
+   void symmetricDifferenceInPlace(const IntSet& otherIntSet);
+   IntSet& operator|=(const IntSet& otherIntSet);
+   IntSet& operator&=(const IntSet& otherIntSet);
+   IntSet& operator-=(const IntSet& otherIntSet);
+   IntSet& operator^=(const IntSet& otherIntSet);
+   bool deserialize(std::istream& in);
+   bool loadFrom(std::istream& in);
+   bool loadFromFile(const char* path);
+   bool loadFromFile(int fd);
+   static LayoutStats layoutStats();
+   static void resetLayoutStats();
+   static void setParallelism(int threads, int cutoff = PARALLEL_CUTOFF);
+   static int parallelThreads();
+   static int parallelCutoff();
+   static IntSet intersectAll(const IntSet* const* sets, int count);
+   static IntSet intersectAll(std::initializer_list<const IntSet*> sets);
+   static IntSet unionAll(const IntSet* const* sets, int count);
+   static IntSet unionAll(std::initializer_list<const IntSet*> sets);
+   static int growGeometric(int current_capacity);
+   static int growDoubling(int current_capacity);
+   static int growFixedStep(int current_capacity);
 
 private:
+   friend class FrozenIntSet; // Reads data directly (see FrozenIntSet.h).
+   friend class ConcurrentIntSet; // Fills a snapshot's data directly.
+   enum Layout { SCANNED, HASHED, DIRECT };
+   typedef int (*ChunkReader)(void* source, char* buffer, int n);
+   enum SetOp { UNION_OP, INTERSECT_OP, DIFFERENCE_OP,
+                SYMMETRIC_DIFFERENCE_OP };
+   static const int LINEAR_SCAN_LIMIT = 32;
+   static const int DIRECT_DENSITY = 2;
+   static const int MAX_DIRECT_RANGE = 1 << 26;
+   static const int OP_MIX_WINDOW = 1024;
    int* data;
    int  capacity;
    int  used;
+   int  tombstones;
+   unsigned* dead;
+   int* index;
+   int  indexCapacity;
+   mutable std::atomic<IntSetShare*> shared;
+   Order ordering;
+   Layout layout;
+   int  indexBase;
+   int  adds;
+   int  removes;
+   GrowthPolicy growth;
+   MemoryResource* memory;
+   unsigned long long hashSum;
+   int  inlineData[INLINE_CAPACITY];
    void resize(int new_capacity);
+   void detach();
+   void releaseArrays();
+   void releaseData();
+   int* newInts(int n) const;
+   void deleteInts(int* array, int n) const;
+   void deleteDead();
+   IntSetShare* newShare() const;
+   void deleteShare(IntSetShare* share) const;
+   IntSetShare* joinShare() const;
+   void grow();
+   void compact();
+   bool tombstoneAt(int position) const;
+   int copyLive(int* out) const;
+   const int* denseData(int*& scratch) const;
+   const int* sortedData(int* small, int*& scratch) const;
+   void adoptData(int* values, int n);
+   int find(int anInt) const;
+   void indexInsert(int position);
+   void indexErase(int position);
+   bool indexCovers(int anInt) const;
+   void rebuildIndex(Layout new_layout, int new_index_capacity);
+   void fillIndex();
+   void reindex();
+   void noteOperation(int& counter);
+   bool churning() const;
+   int addPending(int n);
+   void disown();
+   int* sortedCopy() const;
+   int combineSorted(SetOp op, const int* a, int na, const int* b, int nb,
+                     int* out) const;
+   int filterBy(const int* values, int n, const IntSet& probe,
+                bool keep_found, int* out) const;
+   static int workersFor(int n);
+   static unsigned hashOf(int anInt);
+   static unsigned long long fingerprintOf(int anInt);
+   void refingerprint();
+   bool loadText(ChunkReader readChunk, void* source);
 };
 
 bool operator==(const IntSet& is1, const IntSet& is2);
 
+// The member templates have to be defined where every user of them
+// can see them.
+
+template <class ForwardIterator, class>
+IntSet::IntSet(ForwardIterator first, ForwardIterator last,
+               MemoryResource* resource)
+   : IntSet(int(std::distance(first, last)), resource)
+{
+   addAll(first, last);
+}
+
+template <class ForwardIterator, class>
+int IntSet::addAll(ForwardIterator first, ForwardIterator last)
+{
+   int n = int(std::distance(first, last));
+   if(n <= 0)
+      return 0;
+   detach();
+   compact(); // As for addAll(values, n): pending ints go straight
+   reserve(used + n); // into data, right after the relevant values.
+   std::copy(first, last, data + used);
+   return addPending(n);
+}
+
 #endif
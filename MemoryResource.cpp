@@ -0,0 +1,116 @@
+// FILE: MemoryResource.cpp - implementation file for the memory
+//       resources (See MemoryResource.h for documentation.)
+//
+// INVARIANT for the MonotonicArena class:
+// (1) The blocks taken from upstream form a singly linked list
+//     headed by blocks (most recent first); each starts with its
+//     Block header, which records its size for giving it back.
+// (2) cursor through end is the unused tail of the most recent block
+//     (both are NULL while there is no block); everything before
+//     cursor has been handed out.
+// (3) nextBlockSize is the size of the next block to take (starting
+//     over from firstBlockSize after each release), and held is the
+//     total size of the blocks in the list.
+
+#include "MemoryResource.h"
+#include <new>
+using namespace std;
+
+namespace
+{
+    class NewDeleteResource : public MemoryResource
+    {
+    public:
+        void* allocate(size_t bytes, size_t alignment)
+        {
+            (void)alignment; // ::operator new suits any fundamental type.
+            return ::operator new(bytes);
+        }
+        void deallocate(void* p, size_t bytes, size_t alignment)
+        {
+            (void)bytes;
+            (void)alignment;
+            ::operator delete(p);
+        }
+    };
+}
+
+MemoryResource* newDeleteResource()
+{
+    static NewDeleteResource resource; // Stateless, so shared by all.
+    return &resource;
+}
+
+const size_t MonotonicArena::DEFAULT_BLOCK_SIZE;
+
+struct MonotonicArena::Block
+{
+    Block* next;
+    size_t size;
+};
+
+MonotonicArena::MonotonicArena(size_t block_size, MemoryResource* upstream)
+    : upstream(upstream != NULL ? upstream : newDeleteResource()),
+      blocks(NULL), cursor(NULL), end(NULL),
+      firstBlockSize(block_size > 0 ? block_size : DEFAULT_BLOCK_SIZE),
+      nextBlockSize(firstBlockSize), held(0)
+{
+}
+
+MonotonicArena::~MonotonicArena()
+{
+    release();
+}
+
+void* MonotonicArena::allocate(size_t bytes, size_t alignment)
+{
+    size_t misalign = size_t(cursor) & (alignment - 1);
+    size_t skip = misalign != 0 ? alignment - misalign : 0;
+    if(cursor == NULL || size_t(end - cursor) < skip + bytes)
+    {   // Take a new block big enough for the header, the request,
+        // and the worst-case padding to align it.
+        size_t need = sizeof(Block) + bytes + alignment;
+        size_t size = nextBlockSize > need ? nextBlockSize : need;
+        Block* block = static_cast<Block*>(
+            upstream->allocate(size, alignof(Block)));
+        block->next = blocks;
+        block->size = size;
+        blocks = block;
+        held += size;
+        nextBlockSize *= 2; // Fewer, larger blocks as demand grows.
+
+        cursor = reinterpret_cast<char*>(block + 1);
+        end = reinterpret_cast<char*>(block) + size;
+        misalign = size_t(cursor) & (alignment - 1);
+        skip = misalign != 0 ? alignment - misalign : 0;
+    }
+    void* p = cursor + skip;
+    cursor += skip + bytes;
+    return p;
+}
+
+void MonotonicArena::deallocate(void* p, size_t bytes, size_t alignment)
+{
+    (void)p; // Given back only by release().
+    (void)bytes;
+    (void)alignment;
+}
+
+void MonotonicArena::release()
+{
+    while(blocks != NULL)
+    {
+        Block* next = blocks->next;
+        upstream->deallocate(blocks, blocks->size, alignof(Block));
+        blocks = next;
+    }
+    cursor = NULL;
+    end = NULL;
+    nextBlockSize = firstBlockSize;
+    held = 0;
+}
+
+size_t MonotonicArena::bytesHeld() const
+{
+    return held;
+}
@@ -0,0 +1,110 @@
+// FILE: MemoryResource.h - header file for the memory resources IntSet
+//       can draw its arrays from
+// CLASSES PROVIDED: MemoryResource (an interface through which memory
+//                   is allocated and deallocated, in the manner of
+//                   C++17's std::pmr::memory_resource), and
+//                   MonotonicArena (a MemoryResource that hands out
+//                   memory by bumping a pointer through large blocks
+//                   and gives it all back at once)
+//
+// CLASS MemoryResource
+//   virtual void* allocate(std::size_t bytes, std::size_t alignment) = 0
+//     Pre:  alignment is a power of 2.
+//     Post: The address of at least bytes bytes of memory, aligned to
+//           alignment, is returned; std::bad_alloc is thrown if the
+//           memory cannot be had.
+//   virtual void deallocate(void* p, std::size_t bytes,
+//                           std::size_t alignment) = 0
+//     Pre:  p was returned by allocate(bytes, alignment) of the same
+//           MemoryResource and has not been deallocated since.
+//     Post: The memory p addresses has been given back.
+//
+// NON-MEMBER FUNCTION
+//   MemoryResource* newDeleteResource()
+//     Pre:  (none)
+//     Post: A MemoryResource that allocates with ::operator new and
+//           deallocates with ::operator delete is returned. It is the
+//           one an IntSet uses unless it is given another, and it is
+//           safe to use from any number of threads at once.
+//
+// CLASS MonotonicArena
+//   CONSTANT
+//     static const std::size_t DEFAULT_BLOCK_SIZE = ____
+//       MonotonicArena::DEFAULT_BLOCK_SIZE is the # of bytes of the
+//       first block a MonotonicArena created by the default
+//       constructor takes from upstream.
+//   CONSTRUCTOR
+//     MonotonicArena(std::size_t block_size = DEFAULT_BLOCK_SIZE,
+//                    MemoryResource* upstream = NULL)
+//       Post: The invoking MonotonicArena holds no memory yet; it
+//             takes blocks from upstream (newDeleteResource() if
+//             upstream is NULL), the first of block_size bytes (or
+//             DEFAULT_BLOCK_SIZE, if block_size is 0) and each later
+//             one twice the size of the one before (or as large as a
+//             single request needs, if that is more).
+//   DESTRUCTOR
+//     ~MonotonicArena()
+//       Post: As for release().
+//   MEMBER FUNCTIONS
+//     void* allocate(std::size_t bytes, std::size_t alignment)
+//       Post: As for MemoryResource, carved out of the current block
+//             (a new block is taken from upstream when it runs out).
+//     void deallocate(void* p, std::size_t bytes, std::size_t alignment)
+//       Post: Nothing is done: the memory is only given back, all of
+//             it together, by release().
+//     void release()
+//       Post: Every block has been given back to upstream, so all the
+//             memory allocate has handed out is gone; the invoking
+//             MonotonicArena can be used again from scratch (starting
+//             over at the block size it was constructed with).
+//     std::size_t bytesHeld() const
+//       Post: The # of bytes of the blocks currently taken from
+//             upstream is returned.
+//   NOTE: A MonotonicArena is meant for a batch of short-lived
+//         objects (such as the IntSets built for one request) that
+//         all go away before the arena is released. It does no
+//         locking, so it must not be used from two threads at once,
+//         and it cannot be copied.
+
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+
+#include <cstddef>
+
+class MemoryResource
+{
+public:
+   virtual ~MemoryResource() {}
+   virtual void* allocate(std::size_t bytes, std::size_t alignment) = 0;
+   virtual void deallocate(void* p, std::size_t bytes,
+                           std::size_t alignment) = 0;
+};
+
+MemoryResource* newDeleteResource();
+
+class MonotonicArena : public MemoryResource
+{
+public:
+   static const std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+   MonotonicArena(std::size_t block_size = DEFAULT_BLOCK_SIZE,
+                  MemoryResource* upstream = NULL);
+   ~MonotonicArena();
+   void* allocate(std::size_t bytes, std::size_t alignment);
+   void deallocate(void* p, std::size_t bytes, std::size_t alignment);
+   void release();
+   std::size_t bytesHeld() const;
+
+private:
+   struct Block;
+   MemoryResource* upstream;
+   Block* blocks;
+   char* cursor;
+   char* end;
+   std::size_t firstBlockSize;
+   std::size_t nextBlockSize;
+   std::size_t held;
+   MonotonicArena(const MonotonicArena&);
+   MonotonicArena& operator=(const MonotonicArena&);
+};
+
+#endif
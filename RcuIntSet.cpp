@@ -0,0 +1,256 @@
+// FILE: RcuIntSet.cpp - implementation file for RcuIntSet class
+//       (See RcuIntSet.h for documentation.)
+// INVARIANT for the RcuIntSet class:
+// (1) current points to the version readers are to use; its set has
+//     no tombstones, so IntSet's const member functions only read it
+//     (and any number of threads may run them on it at once). No
+//     version's set is changed, copied from by the copy constructor
+//     (which marks the source as shared), or deleted while it might
+//     be reachable by a reader.
+// (2) retired heads a list (linked through next) of the versions that
+//     have been replaced by a newer one but not yet deleted; each has
+//     the epoch it was retired in as retiredAt. Only a writer holding
+//     writeLock (or the destructor) touches retired.
+// (3) Readers of all RcuIntSets share one epoch and one table of
+//     reader slots. While a thread is inside enter()...leave() its
+//     slot holds the epoch it read on entering; otherwise it holds
+//     QUIESCENT. A version retired in epoch e can only be in use by a
+//     reader whose slot holds an epoch below e, so it is deleted once
+//     no slot does.
+// (4) A thread that found no free slot reads through overflowReaders
+//     instead: it is counted there while inside enter()...leave().
+//     Such a reader may be using any version, so nothing is deleted
+//     while overflowReaders is not 0 (it is left for a later reclaim).
+//
+// DOCUMENTATION for private member (helper) functions:
+//   const RcuVersion* enter() const
+//     Pre:  The calling thread is not already inside enter()/leave().
+//     Post: The calling thread's reader slot announces the current
+//           epoch (or, if it has none, the thread is counted in
+//           overflowReaders), and the current version is returned; it
+//           stays valid until the thread calls leave().
+//   void leave() const
+//     Pre:  The calling thread is inside enter()/leave().
+//     Post: The calling thread's reader slot is QUIESCENT again (or
+//           its count in overflowReaders has been taken back).
+//   void publish(IntSet& next)
+//     Pre:  The calling thread holds writeLock, and next has no
+//           tombstones.
+//     Post: A version holding next's elements (next itself is left
+//           empty) has replaced current; the replaced version has
+//           been retired and whatever can be reclaimed has been.
+//   void reclaim()
+//     Pre:  The calling thread holds writeLock.
+//     Post: Every retired version no reader can still be using has
+//           been deleted.
+
+#include "RcuIntSet.h"
+#include <thread>
+#include <utility>
+using namespace std;
+
+struct RcuVersion
+{
+    IntSet set;
+    unsigned long retiredAt;
+    RcuVersion* next;
+    RcuVersion(IntSet&& s) : set(std::move(s)), retiredAt(0), next(NULL) {}
+};
+
+namespace
+{
+    const unsigned long QUIESCENT = 0; // Epochs start at 1.
+    const size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) ReaderSlot // Each on its own cache line,
+    {                                     // so readers never contend.
+        atomic<unsigned long> epoch;
+        atomic<bool> taken;
+    };
+
+    // Zero-initialized (static storage): every slot QUIESCENT and free.
+    ReaderSlot readerSlots[RcuIntSet::MAX_READER_THREADS];
+    atomic<unsigned long> globalEpoch(1);
+
+    // Reads a thread without a slot makes before it looks for one again.
+    const int SLOT_RETRY_READS = 1024;
+
+    struct SlotHolder // Gives the thread's slot back when it exits.
+    {
+        ReaderSlot* slot;
+        int skips; // Reads left before looking for a slot again.
+        SlotHolder() : slot(NULL), skips(0) {}
+        ~SlotHolder()
+        {
+            if(slot != NULL)
+                slot->taken.store(false, memory_order_release);
+        }
+    };
+    thread_local SlotHolder heldSlot;
+
+    // The calling thread's slot, taken on its first read; NULL if every
+    // slot is taken (see (4)).
+    ReaderSlot* mySlot()
+    {
+        if(heldSlot.slot != NULL) // Every read but a thread's first.
+            return heldSlot.slot;
+        if(heldSlot.skips > 0)
+        {
+            heldSlot.skips--;
+            return NULL;
+        }
+        for(int i = 0; i < RcuIntSet::MAX_READER_THREADS; i++)
+        {
+            bool expected = false;
+            if(!readerSlots[i].taken.load(memory_order_relaxed) &&
+               readerSlots[i].taken.compare_exchange_strong(expected, true))
+            {
+                heldSlot.slot = &readerSlots[i];
+                return heldSlot.slot;
+            }
+        }
+        heldSlot.skips = SLOT_RETRY_READS; // All taken: not worth a
+        return NULL;                       // scan on every read.
+    }
+}
+
+RcuIntSet::RcuIntSet()
+    : current(new RcuVersion(IntSet())), retired(NULL), overflowReaders(0)
+{
+}
+
+RcuIntSet::~RcuIntSet()
+{
+    while(retired != NULL)
+    {
+        RcuVersion* next = retired->next;
+        delete retired;
+        retired = next;
+    }
+    delete current.load();
+}
+
+int RcuIntSet::size() const
+{
+    int result = enter()->set.size();
+    leave();
+    return result;
+}
+
+bool RcuIntSet::isEmpty() const
+{
+    return size() == 0;
+}
+
+bool RcuIntSet::contains(int anInt) const
+{
+    bool result = enter()->set.contains(anInt);
+    leave();
+    return result;
+}
+
+IntSet RcuIntSet::snapshot() const
+{
+    IntSet copy;
+    const RcuVersion* version = enter();
+    copy.setOrder(version->set.order());
+    copy.unionInPlace(version->set); // Only reads the version (1).
+    leave();
+    return copy;
+}
+
+void RcuIntSet::DumpData(ostream& out) const
+{
+    enter()->set.dumpFast(out);
+    leave();
+}
+
+void RcuIntSet::reset()
+{
+    lock_guard<mutex> hold(writeLock);
+    if(current.load()->set.isEmpty())
+        return;
+    IntSet empty;
+    publish(empty);
+}
+
+bool RcuIntSet::add(int anInt)
+{
+    lock_guard<mutex> hold(writeLock);
+    const IntSet& now = current.load()->set; // No other writer can
+    if(now.contains(anInt))                  // retire it meanwhile.
+        return false;
+    IntSet next = now.unionWith(IntSet(&anInt, 1));
+    publish(next);
+    return true;
+}
+
+bool RcuIntSet::remove(int anInt)
+{
+    lock_guard<mutex> hold(writeLock);
+    const IntSet& now = current.load()->set;
+    if(!now.contains(anInt))
+        return false;
+    IntSet next = now.subtract(IntSet(&anInt, 1)); // Made afresh, so it
+    publish(next);                                 // has no tombstones.
+    return true;
+}
+
+const RcuVersion* RcuIntSet::enter() const
+{
+    ReaderSlot* slot = mySlot();
+    // Announce the epoch (or the count) before reading current (all
+    // seq_cst): a writer that then sees the slot QUIESCENT (or the
+    // count 0) retired its version before this read, so the read
+    // finds a newer one.
+    if(slot != NULL)
+        slot->epoch.store(globalEpoch.load());
+    else
+        overflowReaders.fetch_add(1);
+    return current.load();
+}
+
+void RcuIntSet::leave() const
+{
+    if(heldSlot.slot != NULL) // Only enter() takes a slot, so it is the
+        heldSlot.slot->epoch.store(QUIESCENT, memory_order_release);
+    else                      // one enter() announced on.
+        overflowReaders.fetch_sub(1, memory_order_release);
+}
+
+void RcuIntSet::publish(IntSet& next)
+{
+    RcuVersion* old = current.exchange(new RcuVersion(std::move(next)));
+    // Readers announcing this new epoch (or later) can only find the
+    // new version, so the old one is safe once all earlier readers go.
+    old->retiredAt = globalEpoch.fetch_add(1) + 1;
+    old->next = retired;
+    retired = old;
+    reclaim();
+}
+
+void RcuIntSet::reclaim()
+{
+    if(overflowReaders.load() != 0) // Could be using any version (4).
+        return;
+    unsigned long oldest = globalEpoch.load(); // Oldest epoch in use.
+    for(int i = 0; i < MAX_READER_THREADS; i++)
+    {
+        unsigned long e = readerSlots[i].epoch.load();
+        if(e != QUIESCENT && e < oldest)
+            oldest = e;
+    }
+
+    RcuVersion** link = &retired;
+    while(*link != NULL)
+    {
+        RcuVersion* version = *link;
+        if(version->retiredAt <= oldest) // No reader from before it left.
+        {
+            *link = version->next;
+            delete version;
+        }
+        else
+            link = &version->next;
+    }
+}
@@ -0,0 +1,107 @@
+// FILE: RcuIntSet.h - header file for RcuIntSet class
+// CLASS PROVIDED: RcuIntSet (a container class for a set of int
+//                 values that any number of threads may use at once,
+//                 built for workloads that are nearly all lookups)
+//
+// An RcuIntSet holds the same kind of set as an IntSet (see IntSet.h)
+// and, like a ConcurrentIntSet, needs no locking by the caller. It
+// works in the manner of read-copy-update: the set is kept as a series
+// of versions, each an IntSet that is never changed once published.
+// contains, size and the other accessors take no lock at all; they
+// read whichever version is current when they start, and never wait
+// for a writer or for one another. add, remove and reset copy the
+// current version, change the copy and publish it in place of the
+// old one (writers do take turns, on a lock of their own). A version
+// replaced while readers may still be using it is reclaimed later,
+// once every reader that could have seen it has finished (epoch-based
+// reclamation).
+//
+// So lookups scale with the number of threads reading, while each
+// change costs time and memory in proportion to the size of the set:
+// an RcuIntSet suits sets that are read far more often than they are
+// changed. (For a steadier mix, use a ConcurrentIntSet.)
+//
+// CONSTANT
+//   static const int MAX_READER_THREADS = ____
+//     RcuIntSet::MAX_READER_THREADS is the # of threads that can hold
+//     a reader slot (for RcuIntSets, any of them) at once: each thread
+//     holds one from its first read until it exits. A thread that
+//     finds every slot taken still reads without waiting, counted
+//     instead in a counter of the RcuIntSet's own that all such
+//     threads share (so their reads contend on it, and while any of
+//     them is reading no replaced version of that RcuIntSet is
+//     reclaimed); it looks for a free slot again every so often.
+//
+// CONSTRUCTOR
+//   RcuIntSet()
+//     Post: The invoking RcuIntSet is initialized to an empty set.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   int size() const
+//   bool isEmpty() const
+//   bool contains(int anInt) const
+//   void DumpData(std::ostream& out) const
+//     Pre/Post: As for the IntSet member function of the same name,
+//           on the version current when the call starts.
+//     Note: DumpData writes the version by IntSet::dumpFast.
+//   IntSet snapshot() const
+//     Pre:  (none)
+//     Post: A copy of the version current when the call starts is
+//           returned (with the elements in the order IntSet would
+//           have kept them).
+//
+// MODIFICATION MEMBER FUNCTIONS
+//   void reset()
+//   bool add(int anInt)
+//   bool remove(int anInt)
+//     Pre/Post: As for the IntSet member function of the same name.
+//     Note: Each call that changes the set publishes a new version, in
+//           O(n) time; calls that leave it as it is publish nothing.
+//
+// DESTRUCTOR
+//   ~RcuIntSet()
+//     Pre:  No other thread is using the invoking RcuIntSet.
+//
+// VALUE SEMANTICS
+//   An RcuIntSet cannot be copied or assigned; take a snapshot for a
+//   copy of its elements.
+
+#ifndef RCU_INT_SET_H
+#define RCU_INT_SET_H
+
+#include "IntSet.h"
+#include <iostream>
+#include <atomic>
+#include <mutex>
+
+struct RcuVersion; // One published IntSet (see RcuIntSet.cpp).
+
+class RcuIntSet
+{
+public:
+   static const int MAX_READER_THREADS = 128;
+   RcuIntSet();
+   ~RcuIntSet();
+   int size() const;
+   bool isEmpty() const;
+   bool contains(int anInt) const;
+   IntSet snapshot() const;
+   void DumpData(std::ostream& out) const;
+   void reset();
+   bool add(int anInt);
+   bool remove(int anInt);
+
+private:
+   std::atomic<RcuVersion*> current;
+   std::mutex writeLock;
+   RcuVersion* retired;
+   mutable std::atomic<int> overflowReaders;
+   const RcuVersion* enter() const;
+   void leave() const;
+   void publish(IntSet& next);
+   void reclaim();
+   RcuIntSet(const RcuIntSet& src);
+   RcuIntSet& operator=(const RcuIntSet& rhs);
+};
+
+#endif
@@ -0,0 +1,868 @@
+// FILE: RoaringIntSet.cpp - implementation file for RoaringIntSet class
+//       (See RoaringIntSet.h for documentation.)
+// INVARIANT for the RoaringIntSet class:
+// (1) Each int value v is mapped to the unsigned 32-bit key
+//     u = v ^ 0x80000000 (so ascending u is ascending v); the high
+//     16 bits of u pick v's chunk and the low 16 bits (its offset)
+//     pick v's place within the chunk.
+// (2) The non-empty chunks are stored in chunks[0] through
+//     chunks[used - 1] in ascending order of key; chunks is a
+//     dynamic array of capacity containers. No chunk is stored
+//     without at least one value.
+// (3) The member variable total holds the # of distinct int values
+//     in the RoaringIntSet (the sum of every chunk's cardinality).
+// (4) Each chunk's container is of one of three kinds:
+//     ARRAY_CONTAINER:  shorts[0..count) holds the chunk's offsets in
+//                       ascending order (count == cardinality, which
+//                       is at most ARRAY_MAX); words is NULL.
+//     BITMAP_CONTAINER: words[0..BITMAP_WORDS) has bit (o % 64) of
+//                       words[o / 64] set for each offset o; shorts
+//                       is NULL.
+//     RUN_CONTAINER:    shorts[2 * r] and shorts[2 * r + 1] hold the
+//                       start and length of run r (the run covers
+//                       offsets start through start + length), for r
+//                       from 0 through count - 1; runs are ascending
+//                       and neither overlap nor touch. words is NULL.
+//     capacity is the # of offsets (ARRAY) or runs (RUN) that shorts
+//     has room for.
+//     Note: add and remove keep whichever kind a container already
+//           is, converting only when it grows past what that kind
+//           is good for (an array past ARRAY_MAX values, runs bigger
+//           than a bitmap, a bitmap emptied to ARRAY_MAX / 2). The
+//           containers made by the set operations are always of the
+//           smallest kind for their contents.
+//
+// DOCUMENTATION for private member (helper) functions:
+//   int findChunk(unsigned short key) const
+//     Pre:  (none)
+//     Post: The smallest position i in [0, used] is returned such
+//           that i == used or chunks[i].key >= key.
+//   RoaringContainer& insertChunk(int position, unsigned short key)
+//     Pre:  findChunk(key) == position and chunks[position] (if any)
+//           does not have key.
+//     Post: An empty ARRAY_CONTAINER for key has been inserted at
+//           position (growing chunks as needed) and is returned.
+//     Note: The caller must add a value to it (see (2)).
+//   void eraseChunk(int position)
+//     Pre:  0 <= position < used.
+//     Post: The chunk at position has been released and removed.
+//   void append(RoaringContainer& c)
+//     Pre:  c is non-empty and its key is greater than every key
+//           already stored; chunks has room for one more container.
+//     Post: c has been moved to the end of chunks (c is left without
+//           any storage of its own) and total updated.
+//   void resize(int new_capacity)
+//     Pre:  (none)
+//     Post: chunks has room for new_capacity containers (or used of
+//           them if new_capacity is smaller, and at least 1).
+//
+// DOCUMENTATION for file-scope helper functions (one container):
+//   bool containerContains(const RoaringContainer& c,
+//                          unsigned short low)
+//   bool containerAdd(RoaringContainer& c, unsigned short low)
+//   bool containerRemove(RoaringContainer& c, unsigned short low)
+//     Post: As for contains, add and remove, for the offset low of
+//           c's chunk.
+//   void toBitmap(const RoaringContainer& c, unsigned long long* words)
+//     Pre:  words has room for BITMAP_WORDS words.
+//     Post: words holds c's offsets as a bitmap.
+//   void fromBitmap(RoaringContainer& c, const unsigned long long* words)
+//     Pre:  c has no storage of its own (or it has been released).
+//     Post: c (keeping its key) holds the offsets set in words, as
+//           whichever kind of container takes the fewest bytes.
+//   void containerUnion(...), containerIntersect(...),
+//   void containerDifference(...)
+//     Pre:  a and b have the same key; out has no storage.
+//     Post: out holds the union, intersection or difference (a - b)
+//           of a and b (possibly with cardinality 0).
+//   bool containerSubset(const RoaringContainer& a,
+//                        const RoaringContainer& b)
+//     Post: true is returned if every offset of a is an offset of b.
+
+#include "RoaringIntSet.h"
+#include <iostream>
+#include <cassert>
+using namespace std;
+
+struct RoaringContainer
+{
+    unsigned short key;         // High 16 bits shared by the chunk.
+    unsigned char  kind;        // One of the kinds below.
+    int cardinality;            // # of values in the chunk.
+    int count;                  // # of offsets (ARRAY) or runs (RUN).
+    int capacity;               // Room in shorts, in offsets or runs.
+    unsigned short* shorts;     // Offsets, or (start, length) pairs.
+    unsigned long long* words;  // Bits of a BITMAP.
+};
+
+static const unsigned char ARRAY_CONTAINER = 0;
+static const unsigned char BITMAP_CONTAINER = 1;
+static const unsigned char RUN_CONTAINER = 2;
+static const int ARRAY_MAX = 4096;     // Past this, a bitmap is smaller.
+static const int BITMAP_WORDS = 1024;  // 2^16 bits.
+
+static unsigned keyOf(int anInt)
+{
+    return unsigned(anInt) ^ 0x80000000U;
+}
+
+static int valueOf(unsigned short key, unsigned low)
+{
+    return int(((unsigned(key) << 16) | low) ^ 0x80000000U);
+}
+
+static void initContainer(RoaringContainer& c, unsigned short key)
+{
+    c.key = key;
+    c.kind = ARRAY_CONTAINER;
+    c.cardinality = 0;
+    c.count = 0;
+    c.capacity = 0;
+    c.shorts = NULL;
+    c.words = NULL;
+}
+
+static void freeContainer(RoaringContainer& c)
+{
+    delete[] c.shorts;
+    delete[] c.words;
+    c.shorts = NULL;
+    c.words = NULL;
+}
+
+static void copyContainer(RoaringContainer& to, const RoaringContainer& from)
+{
+    to = from; // Scalars first, then deep copies of the storage.
+    to.shorts = NULL;
+    to.words = NULL;
+    if(from.kind == BITMAP_CONTAINER)
+    {
+        to.words = new unsigned long long[BITMAP_WORDS];
+        for(int i = 0; i < BITMAP_WORDS; i++)
+            to.words[i] = from.words[i];
+    }
+    else
+    {
+        int n = (from.kind == RUN_CONTAINER) ? 2 * from.count : from.count;
+        to.capacity = from.count; // Copies are sized exactly.
+        to.shorts = new unsigned short[n > 0 ? n : 1];
+        for(int i = 0; i < n; i++)
+            to.shorts[i] = from.shorts[i];
+    }
+}
+
+// Makes room in shorts for at least `units` offsets (ARRAY) or runs.
+static void reserveUnits(RoaringContainer& c, int units)
+{
+    if(units <= c.capacity)
+        return;
+    int perUnit = (c.kind == RUN_CONTAINER) ? 2 : 1;
+    int newCapacity = int(1.5 * c.capacity) + 4;
+    if(newCapacity < units)
+        newCapacity = units;
+    unsigned short* grown = new unsigned short[newCapacity * perUnit];
+    for(int i = 0; i < c.count * perUnit; i++)
+        grown[i] = c.shorts[i];
+    delete[] c.shorts;
+    c.shorts = grown;
+    c.capacity = newCapacity;
+}
+
+// First i in [0, n) with a[i] >= low (n if there is none).
+static int lowerBound(const unsigned short* a, int n, unsigned short low)
+{
+    int lo = 0, hi = n;
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if(a[mid] < low)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Last run r of c with start <= low (-1 if there is none).
+static int runBefore(const RoaringContainer& c, unsigned short low)
+{
+    int lo = 0, hi = c.count;
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if(c.shorts[2 * mid] <= low)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+
+static bool containerContains(const RoaringContainer& c, unsigned short low)
+{
+    if(c.kind == BITMAP_CONTAINER)
+        return (c.words[low / 64] >> (low % 64)) & 1ULL;
+    if(c.kind == ARRAY_CONTAINER)
+    {
+        int i = lowerBound(c.shorts, c.count, low);
+        return i < c.count && c.shorts[i] == low;
+    }
+    int r = runBefore(c, low);
+    return r >= 0 && unsigned(low) <= unsigned(c.shorts[2 * r]) + c.shorts[2 * r + 1];
+}
+
+static void setRange(unsigned long long* words, unsigned first, unsigned last)
+{
+    for(unsigned o = first; o <= last; o++) // Whole words at a time
+    {                                       // where the run allows.
+        if(o % 64 == 0 && o + 63 <= last)
+        {
+            words[o / 64] = ~0ULL;
+            o += 63;
+        }
+        else
+            words[o / 64] |= 1ULL << (o % 64);
+    }
+}
+
+static void toBitmap(const RoaringContainer& c, unsigned long long* words)
+{
+    if(c.kind == BITMAP_CONTAINER)
+    {
+        for(int i = 0; i < BITMAP_WORDS; i++)
+            words[i] = c.words[i];
+        return;
+    }
+    for(int i = 0; i < BITMAP_WORDS; i++)
+        words[i] = 0;
+    if(c.kind == ARRAY_CONTAINER)
+    {
+        for(int i = 0; i < c.count; i++)
+            words[c.shorts[i] / 64] |= 1ULL << (c.shorts[i] % 64);
+    }
+    else
+    {
+        for(int r = 0; r < c.count; r++)
+            setRange(words, c.shorts[2 * r], unsigned(c.shorts[2 * r]) + c.shorts[2 * r + 1]);
+    }
+}
+
+static void fromBitmap(RoaringContainer& c, const unsigned long long* words)
+{
+    int cardinality = 0, runs = 0;
+    unsigned long long carry = 0; // Top bit of the previous word.
+    for(int i = 0; i < BITMAP_WORDS; i++)
+    {
+        cardinality += __builtin_popcountll(words[i]);
+        runs += __builtin_popcountll(words[i] & ~((words[i] << 1) | carry));
+        carry = words[i] >> 63;
+    }
+
+    int arrayBytes = (cardinality <= ARRAY_MAX) ? 2 * cardinality : 1 << 30;
+    int bitmapBytes = 8 * BITMAP_WORDS;
+    int runBytes = 2 + 4 * runs;
+
+    c.cardinality = cardinality;
+    c.shorts = NULL;
+    c.words = NULL;
+    if(runBytes < arrayBytes && runBytes < bitmapBytes)
+    {
+        c.kind = RUN_CONTAINER;
+        c.count = 0;
+        c.capacity = runs;
+        c.shorts = new unsigned short[2 * (runs > 0 ? runs : 1)];
+        int o = 0;
+        while(o < BITMAP_WORDS * 64)
+        {
+            if(((words[o / 64] >> (o % 64)) & 1ULL) == 0)
+            {
+                o++;
+                continue;
+            }
+            int start = o;
+            while(o < BITMAP_WORDS * 64 && ((words[o / 64] >> (o % 64)) & 1ULL))
+                o++;
+            c.shorts[2 * c.count] = (unsigned short)start;
+            c.shorts[2 * c.count + 1] = (unsigned short)(o - 1 - start);
+            c.count++;
+        }
+    }
+    else if(arrayBytes <= bitmapBytes)
+    {
+        c.kind = ARRAY_CONTAINER;
+        c.count = 0;
+        c.capacity = cardinality;
+        c.shorts = new unsigned short[cardinality > 0 ? cardinality : 1];
+        for(int i = 0; i < BITMAP_WORDS; i++)
+        {
+            for(unsigned long long w = words[i]; w != 0; w &= w - 1)
+                c.shorts[c.count++] = (unsigned short)(i * 64 + __builtin_ctzll(w));
+        }
+    }
+    else
+    {
+        c.kind = BITMAP_CONTAINER;
+        c.count = 0;
+        c.capacity = 0;
+        c.words = new unsigned long long[BITMAP_WORDS];
+        for(int i = 0; i < BITMAP_WORDS; i++)
+            c.words[i] = words[i];
+    }
+}
+
+// Re-encodes c as whichever kind of container is now smallest.
+static void reencode(RoaringContainer& c)
+{
+    unsigned long long words[BITMAP_WORDS];
+    toBitmap(c, words);
+    freeContainer(c);
+    fromBitmap(c, words);
+}
+
+static bool containerAdd(RoaringContainer& c, unsigned short low)
+{
+    if(c.kind == ARRAY_CONTAINER)
+    {
+        int i = lowerBound(c.shorts, c.count, low);
+        if(i < c.count && c.shorts[i] == low)
+            return false;
+        if(c.count == ARRAY_MAX) // A bitmap is smaller from here on.
+        {
+            unsigned long long* words = new unsigned long long[BITMAP_WORDS];
+            toBitmap(c, words);
+            freeContainer(c);
+            c.kind = BITMAP_CONTAINER;
+            c.count = c.capacity = 0;
+            c.words = words;
+        }
+        else
+        {
+            reserveUnits(c, c.count + 1);
+            for(int j = c.count; j > i; j--)
+                c.shorts[j] = c.shorts[j - 1];
+            c.shorts[i] = low;
+            c.count++;
+            c.cardinality++;
+            return true;
+        }
+    }
+
+    if(c.kind == BITMAP_CONTAINER)
+    {
+        unsigned long long bit = 1ULL << (low % 64);
+        if(c.words[low / 64] & bit)
+            return false;
+        c.words[low / 64] |= bit;
+        c.cardinality++;
+        return true;
+    }
+
+    int r = runBefore(c, low);
+    unsigned end = (r >= 0) ? unsigned(c.shorts[2 * r]) + c.shorts[2 * r + 1] : 0;
+    if(r >= 0 && unsigned(low) <= end)
+        return false;
+    bool joinsBefore = (r >= 0 && unsigned(low) == end + 1);
+    bool joinsAfter = (r + 1 < c.count && unsigned(low) + 1 == c.shorts[2 * (r + 1)]);
+    if(joinsBefore && joinsAfter) // low fills the gap between two runs.
+    {
+        c.shorts[2 * r + 1] = (unsigned short)(unsigned(c.shorts[2 * (r + 1)])
+                                               + c.shorts[2 * (r + 1) + 1] - c.shorts[2 * r]);
+        for(int j = r + 1; j < c.count - 1; j++)
+        {
+            c.shorts[2 * j] = c.shorts[2 * (j + 1)];
+            c.shorts[2 * j + 1] = c.shorts[2 * (j + 1) + 1];
+        }
+        c.count--;
+    }
+    else if(joinsBefore)
+        c.shorts[2 * r + 1]++;
+    else if(joinsAfter)
+    {
+        c.shorts[2 * (r + 1)]--;
+        c.shorts[2 * (r + 1) + 1]++;
+    }
+    else // A run of its own.
+    {
+        reserveUnits(c, c.count + 1);
+        for(int j = c.count; j > r + 1; j--)
+        {
+            c.shorts[2 * j] = c.shorts[2 * (j - 1)];
+            c.shorts[2 * j + 1] = c.shorts[2 * (j - 1) + 1];
+        }
+        c.shorts[2 * (r + 1)] = low;
+        c.shorts[2 * (r + 1) + 1] = 0;
+        c.count++;
+    }
+    c.cardinality++;
+    if(2 + 4 * c.count > 8 * BITMAP_WORDS) // Runs have become bigger
+        reencode(c);                       // than a bitmap would be.
+    return true;
+}
+
+static bool containerRemove(RoaringContainer& c, unsigned short low)
+{
+    if(c.kind == ARRAY_CONTAINER)
+    {
+        int i = lowerBound(c.shorts, c.count, low);
+        if(i == c.count || c.shorts[i] != low)
+            return false;
+        for(int j = i; j < c.count - 1; j++)
+            c.shorts[j] = c.shorts[j + 1];
+        c.count--;
+        c.cardinality--;
+        return true;
+    }
+
+    if(c.kind == BITMAP_CONTAINER)
+    {
+        unsigned long long bit = 1ULL << (low % 64);
+        if((c.words[low / 64] & bit) == 0)
+            return false;
+        c.words[low / 64] &= ~bit;
+        c.cardinality--;
+        if(c.cardinality <= ARRAY_MAX / 2) // Well below the point where
+            reencode(c);                   // the bitmap paid for itself.
+        return true;
+    }
+
+    int r = runBefore(c, low);
+    if(r < 0)
+        return false;
+    unsigned start = c.shorts[2 * r];
+    unsigned end = start + c.shorts[2 * r + 1];
+    if(unsigned(low) > end)
+        return false;
+
+    if(start == end) // The run was just low.
+    {
+        for(int j = r; j < c.count - 1; j++)
+        {
+            c.shorts[2 * j] = c.shorts[2 * (j + 1)];
+            c.shorts[2 * j + 1] = c.shorts[2 * (j + 1) + 1];
+        }
+        c.count--;
+    }
+    else if(unsigned(low) == start)
+    {
+        c.shorts[2 * r]++;
+        c.shorts[2 * r + 1]--;
+    }
+    else if(unsigned(low) == end)
+        c.shorts[2 * r + 1]--;
+    else // Split the run around low.
+    {
+        reserveUnits(c, c.count + 1);
+        for(int j = c.count; j > r + 1; j--)
+        {
+            c.shorts[2 * j] = c.shorts[2 * (j - 1)];
+            c.shorts[2 * j + 1] = c.shorts[2 * (j - 1) + 1];
+        }
+        c.shorts[2 * r + 1] = (unsigned short)(low - 1 - start);
+        c.shorts[2 * (r + 1)] = (unsigned short)(low + 1);
+        c.shorts[2 * (r + 1) + 1] = (unsigned short)(end - low - 1);
+        c.count++;
+    }
+    c.cardinality--;
+    if(2 + 4 * c.count > 8 * BITMAP_WORDS)
+        reencode(c);
+    return true;
+}
+
+static void containerUnion(const RoaringContainer& a, const RoaringContainer& b,
+                           RoaringContainer& out)
+{
+    initContainer(out, a.key);
+    if(a.kind == ARRAY_CONTAINER && b.kind == ARRAY_CONTAINER &&
+       a.count + b.count <= ARRAY_MAX) // Stays an array: merge directly.
+    {
+        out.shorts = new unsigned short[a.count + b.count > 0 ? a.count + b.count : 1];
+        out.capacity = a.count + b.count;
+        int i = 0, j = 0;
+        while(i < a.count || j < b.count)
+        {
+            if(j == b.count || (i < a.count && a.shorts[i] < b.shorts[j]))
+                out.shorts[out.count++] = a.shorts[i++];
+            else if(i == a.count || b.shorts[j] < a.shorts[i])
+                out.shorts[out.count++] = b.shorts[j++];
+            else
+            {
+                out.shorts[out.count++] = a.shorts[i++];
+                j++;
+            }
+        }
+        out.cardinality = out.count;
+        return;
+    }
+
+    unsigned long long words[BITMAP_WORDS];
+    toBitmap(a, words);
+    if(b.kind == BITMAP_CONTAINER)
+    {
+        for(int i = 0; i < BITMAP_WORDS; i++)
+            words[i] |= b.words[i];
+    }
+    else if(b.kind == ARRAY_CONTAINER)
+    {
+        for(int i = 0; i < b.count; i++)
+            words[b.shorts[i] / 64] |= 1ULL << (b.shorts[i] % 64);
+    }
+    else
+    {
+        for(int r = 0; r < b.count; r++)
+            setRange(words, b.shorts[2 * r], unsigned(b.shorts[2 * r]) + b.shorts[2 * r + 1]);
+    }
+    fromBitmap(out, words);
+}
+
+static void containerIntersect(const RoaringContainer& a, const RoaringContainer& b,
+                               RoaringContainer& out)
+{
+    initContainer(out, a.key);
+    if(a.kind == ARRAY_CONTAINER || b.kind == ARRAY_CONTAINER)
+    {
+        const RoaringContainer& walked = (a.kind == ARRAY_CONTAINER) ? a : b;
+        const RoaringContainer& probed = (a.kind == ARRAY_CONTAINER) ? b : a;
+        out.shorts = new unsigned short[walked.count > 0 ? walked.count : 1];
+        out.capacity = walked.count;
+        for(int i = 0; i < walked.count; i++)
+        {
+            if(containerContains(probed, walked.shorts[i]))
+                out.shorts[out.count++] = walked.shorts[i];
+        }
+        out.cardinality = out.count;
+        return;
+    }
+
+    unsigned long long words[BITMAP_WORDS], other[BITMAP_WORDS];
+    toBitmap(a, words);
+    toBitmap(b, other);
+    for(int i = 0; i < BITMAP_WORDS; i++)
+        words[i] &= other[i];
+    fromBitmap(out, words);
+}
+
+static void containerDifference(const RoaringContainer& a, const RoaringContainer& b,
+                                RoaringContainer& out)
+{
+    initContainer(out, a.key);
+    if(a.kind == ARRAY_CONTAINER)
+    {
+        out.shorts = new unsigned short[a.count > 0 ? a.count : 1];
+        out.capacity = a.count;
+        for(int i = 0; i < a.count; i++)
+        {
+            if(!containerContains(b, a.shorts[i]))
+                out.shorts[out.count++] = a.shorts[i];
+        }
+        out.cardinality = out.count;
+        return;
+    }
+
+    unsigned long long words[BITMAP_WORDS], other[BITMAP_WORDS];
+    toBitmap(a, words);
+    toBitmap(b, other);
+    for(int i = 0; i < BITMAP_WORDS; i++)
+        words[i] &= ~other[i];
+    fromBitmap(out, words);
+}
+
+static bool containerSubset(const RoaringContainer& a, const RoaringContainer& b)
+{
+    if(a.cardinality > b.cardinality)
+        return false;
+    if(a.kind == ARRAY_CONTAINER)
+    {
+        for(int i = 0; i < a.count; i++)
+        {
+            if(!containerContains(b, a.shorts[i]))
+                return false;
+        }
+        return true;
+    }
+
+    unsigned long long words[BITMAP_WORDS], other[BITMAP_WORDS];
+    toBitmap(a, words);
+    toBitmap(b, other);
+    for(int i = 0; i < BITMAP_WORDS; i++)
+    {
+        if(words[i] & ~other[i])
+            return false;
+    }
+    return true;
+}
+
+int RoaringIntSet::findChunk(unsigned short key) const
+{
+    int lo = 0, hi = used;
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if(chunks[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void RoaringIntSet::resize(int new_capacity)
+{
+    if(new_capacity < used)
+        new_capacity = used;
+    if(new_capacity <= 0)
+        new_capacity = DEFAULT_CAPACITY;
+    capacity = new_capacity;
+
+    RoaringContainer* newChunks = new RoaringContainer[capacity];
+    for(int i = 0; i < used; i++)
+        newChunks[i] = chunks[i]; // Containers move; their storage stays put.
+
+    delete[] chunks;
+    chunks = newChunks;
+}
+
+RoaringContainer& RoaringIntSet::insertChunk(int position, unsigned short key)
+{
+    if(used >= capacity)
+        resize(int(1.5 * capacity) + 1);
+    for(int i = used; i > position; i--)
+        chunks[i] = chunks[i - 1];
+    initContainer(chunks[position], key);
+    used++;
+    return chunks[position];
+}
+
+void RoaringIntSet::eraseChunk(int position)
+{
+    freeContainer(chunks[position]);
+    for(int i = position; i < used - 1; i++)
+        chunks[i] = chunks[i + 1];
+    used--;
+}
+
+void RoaringIntSet::append(RoaringContainer& c)
+{
+    chunks[used++] = c;
+    total += c.cardinality;
+    c.shorts = NULL; // Now owned by chunks[used - 1].
+    c.words = NULL;
+}
+
+RoaringIntSet::RoaringIntSet(int initial_capacity) : capacity(initial_capacity),
+                                                     used(0), total(0)
+{
+    if(initial_capacity <= 0)
+        capacity = DEFAULT_CAPACITY;
+    chunks = new RoaringContainer[capacity];
+}
+
+RoaringIntSet::RoaringIntSet(const RoaringIntSet& src) : capacity(src.used > 0 ? src.used : 1),
+                                                         used(src.used), total(src.total)
+{
+    chunks = new RoaringContainer[capacity];
+    for(int i = 0; i < used; i++)
+        copyContainer(chunks[i], src.chunks[i]);
+}
+
+RoaringIntSet::~RoaringIntSet()
+{
+    for(int i = 0; i < used; i++)
+        freeContainer(chunks[i]);
+    delete[] chunks;
+    chunks = NULL;
+}
+
+RoaringIntSet& RoaringIntSet::operator=(const RoaringIntSet& rhs)
+{
+    if(this == &rhs)
+        return *this;
+
+    RoaringIntSet copy(rhs); // Copy first, then swap the storage in.
+    RoaringContainer* oldChunks = chunks;
+    int oldUsed = used;
+    chunks = copy.chunks;
+    capacity = copy.capacity;
+    used = copy.used;
+    total = copy.total;
+    copy.chunks = oldChunks; // Released by copy's destructor.
+    copy.used = oldUsed;
+    return *this;
+}
+
+int RoaringIntSet::size() const
+{
+    return total;
+}
+
+bool RoaringIntSet::isEmpty() const
+{
+    return total == 0;
+}
+
+bool RoaringIntSet::contains(int anInt) const
+{
+    unsigned u = keyOf(anInt);
+    int i = findChunk((unsigned short)(u >> 16));
+    return i < used && chunks[i].key == (u >> 16) &&
+           containerContains(chunks[i], (unsigned short)(u & 0xFFFF));
+}
+
+bool RoaringIntSet::isSubsetOf(const RoaringIntSet& otherIntSet) const
+{
+    if(total > otherIntSet.total)
+        return false;
+    int j = 0;
+    for(int i = 0; i < used; i++) // Every chunk needs a matching chunk
+    {                              // in otherIntSet that covers it.
+        while(j < otherIntSet.used && otherIntSet.chunks[j].key < chunks[i].key)
+            j++;
+        if(j == otherIntSet.used || otherIntSet.chunks[j].key != chunks[i].key)
+            return false;
+        if(!containerSubset(chunks[i], otherIntSet.chunks[j]))
+            return false;
+    }
+    return true;
+}
+
+void RoaringIntSet::DumpData(ostream& out) const
+{
+    bool first = true;
+    for(int i = 0; i < used; i++)
+    {
+        const RoaringContainer& c = chunks[i];
+        if(c.kind == ARRAY_CONTAINER)
+        {
+            for(int j = 0; j < c.count; j++)
+            {
+                out << (first ? "" : "  ") << valueOf(c.key, c.shorts[j]);
+                first = false;
+            }
+        }
+        else if(c.kind == BITMAP_CONTAINER)
+        {
+            for(int w = 0; w < BITMAP_WORDS; w++)
+            {
+                for(unsigned long long bits = c.words[w]; bits != 0; bits &= bits - 1)
+                {
+                    out << (first ? "" : "  ") << valueOf(c.key, w * 64 + __builtin_ctzll(bits));
+                    first = false;
+                }
+            }
+        }
+        else
+        {
+            for(int r = 0; r < c.count; r++)
+            {
+                unsigned end = unsigned(c.shorts[2 * r]) + c.shorts[2 * r + 1];
+                for(unsigned low = c.shorts[2 * r]; low <= end; low++)
+                {
+                    out << (first ? "" : "  ") << valueOf(c.key, low);
+                    first = false;
+                }
+            }
+        }
+    }
+}
+
+RoaringIntSet RoaringIntSet::unionWith(const RoaringIntSet& otherIntSet) const
+{
+    RoaringIntSet unionSet(used + otherIntSet.used); // Presized chunk table.
+    int i = 0, j = 0;
+    while(i < used || j < otherIntSet.used)
+    {
+        RoaringContainer c;
+        if(j == otherIntSet.used || (i < used && chunks[i].key < otherIntSet.chunks[j].key))
+            copyContainer(c, chunks[i++]);
+        else if(i == used || otherIntSet.chunks[j].key < chunks[i].key)
+            copyContainer(c, otherIntSet.chunks[j++]);
+        else
+            containerUnion(chunks[i++], otherIntSet.chunks[j++], c);
+        unionSet.append(c);
+    }
+    return unionSet;
+}
+
+RoaringIntSet RoaringIntSet::intersect(const RoaringIntSet& otherIntSet) const
+{
+    RoaringIntSet intersectSet(used < otherIntSet.used ? used : otherIntSet.used);
+    int i = 0, j = 0;
+    while(i < used && j < otherIntSet.used) // Only chunks present in
+    {                                       // both can contribute.
+        if(chunks[i].key < otherIntSet.chunks[j].key)
+            i++;
+        else if(otherIntSet.chunks[j].key < chunks[i].key)
+            j++;
+        else
+        {
+            RoaringContainer c;
+            containerIntersect(chunks[i++], otherIntSet.chunks[j++], c);
+            if(c.cardinality > 0)
+                intersectSet.append(c);
+            freeContainer(c);
+        }
+    }
+    return intersectSet;
+}
+
+RoaringIntSet RoaringIntSet::subtract(const RoaringIntSet& otherIntSet) const
+{
+    RoaringIntSet subSet(used);
+    int j = 0;
+    for(int i = 0; i < used; i++)
+    {
+        while(j < otherIntSet.used && otherIntSet.chunks[j].key < chunks[i].key)
+            j++;
+        RoaringContainer c;
+        if(j == otherIntSet.used || otherIntSet.chunks[j].key != chunks[i].key)
+            copyContainer(c, chunks[i]); // Nothing to take away.
+        else
+            containerDifference(chunks[i], otherIntSet.chunks[j], c);
+        if(c.cardinality > 0)
+            subSet.append(c);
+        freeContainer(c);
+    }
+    return subSet;
+}
+
+void RoaringIntSet::reset()
+{
+    for(int i = 0; i < used; i++)
+        freeContainer(chunks[i]);
+    used = 0;
+    total = 0;
+}
+
+bool RoaringIntSet::add(int anInt)
+{
+    unsigned u = keyOf(anInt);
+    unsigned short key = (unsigned short)(u >> 16);
+    int i = findChunk(key);
+    if(i == used || chunks[i].key != key) // First value of its chunk.
+        insertChunk(i, key);
+    if(!containerAdd(chunks[i], (unsigned short)(u & 0xFFFF)))
+        return false;
+    total++;
+    return true;
+}
+
+bool RoaringIntSet::remove(int anInt)
+{
+    unsigned u = keyOf(anInt);
+    unsigned short key = (unsigned short)(u >> 16);
+    int i = findChunk(key);
+    if(i == used || chunks[i].key != key)
+        return false;
+    if(!containerRemove(chunks[i], (unsigned short)(u & 0xFFFF)))
+        return false;
+    total--;
+    if(chunks[i].cardinality == 0) // See invariant (2).
+        eraseChunk(i);
+    return true;
+}
+
+bool operator==(const RoaringIntSet& is1, const RoaringIntSet& is2)
+{
+    if(is1.size() != is2.size()) // Same size and one a subset of the
+        return false;            // other means the same elements.
+    return is1.isSubsetOf(is2);
+}
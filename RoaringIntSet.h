@@ -0,0 +1,104 @@
+// FILE: RoaringIntSet.h - header file for RoaringIntSet class
+// CLASS PROVIDED: RoaringIntSet (a container class for a set of
+//                 int values, stored as a compressed bitmap)
+//
+// RoaringIntSet offers exactly the same public interface (and the
+// same value semantics) as IntSet (see IntSet.h), so either can be
+// used where the other is. The difference is in how the values are
+// stored: the 32-bit value space is split into 2^16 chunks of 2^16
+// values each, and every non-empty chunk is held in whichever
+// container is smallest for how many values it has and how they
+// cluster:
+//   - an array container (a sorted array of 16-bit offsets, 2 bytes
+//     per value) for sparse chunks,
+//   - a bitmap container (2^16 bits, 8 KB) for dense chunks, or
+//   - a run container (a sorted array of [start, start + length]
+//     runs, 4 bytes per run) for chunks made of long consecutive
+//     stretches of values.
+// contains, add and remove work directly on the one container for
+// the value's chunk, and unionWith, intersect and subtract combine
+// two RoaringIntSets chunk by chunk, container against container.
+//
+// NOTE: A RoaringIntSet keeps no membership timing. DumpData always
+//       inserts the elements in ascending order (just as an IntSet
+//       in IntSet::SORTED_ORDER does), and so do unionWith,
+//       intersect and subtract.
+//
+// CONSTANT
+//   static const int DEFAULT_CAPACITY = ____
+//     RoaringIntSet::DEFAULT_CAPACITY is the # of chunks a
+//     RoaringIntSet created by the default constructor has room for
+//     before it has to grow its table of chunks.
+//
+// CONSTRUCTOR
+//   RoaringIntSet(int initial_capacity = DEFAULT_CAPACITY)
+//     Post: The invoking RoaringIntSet is initialized to an empty
+//           set with room for initial_capacity chunks if
+//           initial_capacity is >= 1, otherwise for
+//           RoaringIntSet::DEFAULT_CAPACITY chunks.
+//
+// MEMBER FUNCTIONS
+//   int size() const
+//   bool isEmpty() const
+//   bool contains(int anInt) const
+//   bool isSubsetOf(const RoaringIntSet& otherIntSet) const
+//   void DumpData(std::ostream& out) const
+//   RoaringIntSet unionWith(const RoaringIntSet& otherIntSet) const
+//   RoaringIntSet intersect(const RoaringIntSet& otherIntSet) const
+//   RoaringIntSet subtract(const RoaringIntSet& otherIntSet) const
+//   void reset()
+//   bool add(int anInt)
+//   bool remove(int anInt)
+//     Pre/Post: As for the IntSet member function of the same name
+//           (with DumpData in ascending order, see NOTE above).
+//
+// NON-MEMBER FUNCTIONS
+//   bool operator==(const RoaringIntSet& is1, const RoaringIntSet& is2)
+//     Pre/Post: As for IntSet's operator==.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may be used with
+//   RoaringIntSet objects.
+
+#ifndef ROARING_INT_SET_H
+#define ROARING_INT_SET_H
+
+#include <iostream>
+
+struct RoaringContainer; // One chunk's container (see RoaringIntSet.cpp).
+
+class RoaringIntSet
+{
+public:
+   static const int DEFAULT_CAPACITY = 1;
+   RoaringIntSet(int initial_capacity = DEFAULT_CAPACITY);
+   RoaringIntSet(const RoaringIntSet& src);
+   ~RoaringIntSet();
+   RoaringIntSet& operator=(const RoaringIntSet& rhs);
+   int size() const;
+   bool isEmpty() const;
+   bool contains(int anInt) const;
+   bool isSubsetOf(const RoaringIntSet& otherIntSet) const;
+   void DumpData(std::ostream& out) const;
+   RoaringIntSet unionWith(const RoaringIntSet& otherIntSet) const;
+   RoaringIntSet intersect(const RoaringIntSet& otherIntSet) const;
+   RoaringIntSet subtract(const RoaringIntSet& otherIntSet) const;
+   void reset();
+   bool add(int anInt);
+   bool remove(int anInt);
+
+private:
+   RoaringContainer* chunks;
+   int capacity;
+   int used;
+   int total;
+   int findChunk(unsigned short key) const;
+   RoaringContainer& insertChunk(int position, unsigned short key);
+   void eraseChunk(int position);
+   void append(RoaringContainer& c);
+   void resize(int new_capacity);
+};
+
+bool operator==(const RoaringIntSet& is1, const RoaringIntSet& is2);
+
+#endif
@@ -0,0 +1,31 @@
+// FILE: SerialFormat.h - the binary format IntSet::serialize writes
+// CONSTANTS PROVIDED: the header fields, flag bits and checksum
+//                     parameters of that format, for IntSet and for
+//                     anything else that reads files it wrote.
+//
+// LAYOUT (all multi-byte fields little-endian)
+//   bytes  0..3   SERIAL_MAGIC
+//   byte   4      SERIAL_VERSION
+//   byte   5      flags (SERIAL_DELTA_VARINT, SERIAL_SORTED)
+//   bytes  6..7   reserved, 0
+//   bytes  8..11  # of elements
+//   bytes 12..15  # of bytes of payload
+//   then the payload (the elements, encoded as the flags say), then
+//   4 bytes of checksum: FNV-1a over every byte before it.
+//   With RAW encoding the payload is exactly 4 bytes per element and
+//   starts SERIAL_HEADER_BYTES in, so it is 4-byte aligned wherever
+//   the file itself starts on such a boundary (e.g. mapped memory).
+
+#ifndef SERIAL_FORMAT_H
+#define SERIAL_FORMAT_H
+
+static const unsigned char SERIAL_MAGIC[4] = { 'I', 'S', 'E', 'T' };
+static const unsigned SERIAL_VERSION = 1;
+static const unsigned SERIAL_DELTA_VARINT = 1; // Flag bits.
+static const unsigned SERIAL_SORTED = 2;
+static const int SERIAL_HEADER_BYTES = 16;
+static const int SERIAL_CHECKSUM_BYTES = 4;
+static const unsigned FNV_OFFSET = 2166136261U;
+static const unsigned FNV_PRIME = 16777619U;
+
+#endif
@@ -0,0 +1,688 @@
+// FILE: SetKernels.cpp - implementation file for the array kernels
+//       (See SetKernels.h for documentation.)
+//
+// DOCUMENTATION for file-scope helper functions:
+//   int mergeUnion(const int* a, int na, const int* b, int nb,
+//                  int* out)
+//   int mergeIntersect(const int* a, int na, const int* b, int nb,
+//                      int* out)
+//   int mergeDifference(const int* a, int na, const int* b, int nb,
+//                       int* out)
+//   int mergeSymmetricDifference(const int* a, int na, const int* b,
+//                                int nb, int* out)
+//     Pre:  As for sortedUnion / sortedIntersect / sortedDifference /
+//           sortedSymmetricDifference.
+//     Post: As for sortedUnion / sortedIntersect / sortedDifference /
+//           sortedSymmetricDifference, by a scalar linear merge of a
+//           and b.
+//   int mergeUnionSse(..., int room), int mergeIntersectSse(...,
+//   int room), int mergeDifferenceSse(..., int room)
+//     Pre:  As for the scalar merge of the same name, except that out
+//           has room for room ints (which is at least the size of
+//           the result); the CPU supports SSE4.2.
+//     Post: As for the scalar merge of the same name, comparing a
+//           block of 4 ints of a with a block of 4 ints of b per
+//           step and finishing the last few ints with the scalar
+//           merge. Nothing is written at or past out[room].
+//   int gallopUnion(const int* small, int ns, const int* big, int nb,
+//                   int* out)
+//   int gallopIntersect(const int* small, int ns, const int* big,
+//                       int nb, int* out)
+//     Pre:  As for sortedUnion / sortedIntersect.
+//     Post: As for sortedUnion / sortedIntersect, but only small is
+//           walked element by element; big is galloped through (and
+//           for gallopUnion, copied across in runs between the
+//           positions found).
+//   int gallopSymmetricDifference(const int* small, int ns,
+//                                 const int* big, int nb, int* out)
+//     Pre:  As for sortedSymmetricDifference.
+//     Post: As for sortedSymmetricDifference, walking small and
+//           copying big across in runs between the positions found.
+//   int gallopDifference(const int* a, int na, const int* b, int nb,
+//                        int* out)
+//     Pre:  As for sortedDifference.
+//     Post: As for sortedDifference, but whichever of a and b is the
+//           smaller is walked and the other is galloped through.
+//   bool haveSse2(), bool haveSse42(), bool haveAvx2(), bool haveAvx512()
+//     Pre:  (none)
+//     Post: true is returned if the CPU running the program supports
+//           the instruction set (checked once, on first use; SSE2 is
+//           part of x86-64, so only 32-bit x86 checks for it).
+
+#include "SetKernels.h"
+#include <algorithm>
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SET_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef SET_KERNELS_X86
+
+static bool haveSse2()
+{
+#ifdef __x86_64__
+    return true;
+#else
+    static const bool supported = (__builtin_cpu_init(),
+                                   __builtin_cpu_supports("sse2") != 0);
+    return supported;
+#endif
+}
+
+static bool haveSse42()
+{
+    static const bool supported = (__builtin_cpu_init(),
+                                   __builtin_cpu_supports("sse4.2") != 0);
+    return supported;
+}
+
+static bool haveAvx2()
+{
+    static const bool supported = (__builtin_cpu_init(),
+                                   __builtin_cpu_supports("avx2") != 0);
+    return supported;
+}
+
+static bool haveAvx512()
+{
+    static const bool supported = (__builtin_cpu_init(),
+                                   __builtin_cpu_supports("avx512f") != 0);
+    return supported;
+}
+
+#else
+
+static bool haveSse42() { return false; }
+static bool haveAvx2() { return false; }
+static bool haveAvx512() { return false; }
+
+#endif
+
+static int scanScalar(const int* a, int n, int target)
+{
+    for(int i = 0; i < n; i++)
+    {
+        if(a[i] == target)
+            return i;
+    }
+    return -1;
+}
+
+#ifdef SET_KERNELS_X86
+
+__attribute__((target("sse2")))
+static int scanSse2(const int* a, int n, int target)
+{
+    __m128i wanted = _mm_set1_epi32(target);
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(a + i));
+        int hits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, wanted)));
+        if(hits != 0)
+            return i + __builtin_ctz(hits); // Lowest lane that matched.
+    }
+    int rest = scanScalar(a + i, n - i, target);
+    return rest == -1 ? -1 : i + rest;
+}
+
+__attribute__((target("avx2")))
+static int scanAvx2(const int* a, int n, int target)
+{
+    __m256i wanted = _mm256_set1_epi32(target);
+    int i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(a + i));
+        int hits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, wanted)));
+        if(hits != 0)
+            return i + __builtin_ctz(hits);
+    }
+    int rest = scanSse2(a + i, n - i, target);
+    return rest == -1 ? -1 : i + rest;
+}
+
+__attribute__((target("avx512f")))
+static int scanAvx512(const int* a, int n, int target)
+{
+    __m512i wanted = _mm512_set1_epi32(target);
+    int i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        __m512i block = _mm512_loadu_si512((const void*)(a + i));
+        unsigned hits = _mm512_cmpeq_epi32_mask(block, wanted);
+        if(hits != 0)
+            return i + __builtin_ctz(hits);
+    }
+    int rest = scanAvx2(a + i, n - i, target);
+    return rest == -1 ? -1 : i + rest;
+}
+
+#endif
+
+int scanFind(const int* a, int n, int target)
+{
+#ifdef SET_KERNELS_X86
+    if(haveAvx512())
+        return scanAvx512(a, n, target);
+    if(haveAvx2())
+        return scanAvx2(a, n, target);
+    if(haveSse2())
+        return scanSse2(a, n, target);
+#endif
+    return scanScalar(a, n, target);
+}
+
+static int mergeUnion(const int* a, int na, const int* b, int nb, int* out)
+{
+    int i = 0, j = 0, k = 0;
+    while(i < na && j < nb)
+    {
+        if(a[i] < b[j])
+            out[k++] = a[i++];
+        else if(b[j] < a[i])
+            out[k++] = b[j++];
+        else
+        {
+            out[k++] = a[i++]; // Common to both, written once.
+            j++;
+        }
+    }
+    while(i < na) // At most one of these two tails is non-empty.
+        out[k++] = a[i++];
+    while(j < nb)
+        out[k++] = b[j++];
+    return k;
+}
+
+static int mergeSymmetricDifference(const int* a, int na, const int* b, int nb,
+                                    int* out)
+{
+    int i = 0, j = 0, k = 0;
+    while(i < na && j < nb)
+    {
+        if(a[i] < b[j])
+            out[k++] = a[i++];
+        else if(b[j] < a[i])
+            out[k++] = b[j++];
+        else
+        {
+            i++; // Common to both, so in neither difference.
+            j++;
+        }
+    }
+    while(i < na)
+        out[k++] = a[i++];
+    while(j < nb)
+        out[k++] = b[j++];
+    return k;
+}
+
+static int mergeIntersect(const int* a, int na, const int* b, int nb, int* out)
+{
+    int i = 0, j = 0, k = 0;
+    while(i < na && j < nb)
+    {
+        if(a[i] < b[j])
+            i++;
+        else if(b[j] < a[i])
+            j++;
+        else
+        {
+            out[k++] = a[i++];
+            j++;
+        }
+    }
+    return k;
+}
+
+static int mergeDifference(const int* a, int na, const int* b, int nb, int* out)
+{
+    int i = 0, j = 0, k = 0;
+    while(i < na && j < nb)
+    {
+        if(a[i] < b[j])
+            out[k++] = a[i++]; // Smaller than anything left in b.
+        else if(b[j] < a[i])
+            j++;
+        else
+        {
+            i++; // In both, so not in the difference.
+            j++;
+        }
+    }
+    while(i < na)
+        out[k++] = a[i++];
+    return k;
+}
+
+#ifdef SET_KERNELS_X86
+
+// packLanes[m] is the pshufb control that moves the lanes whose bits
+// are set in the 4-bit mask m to the front of a vector, in order.
+static const unsigned char packLanes[16][16] __attribute__((aligned(16))) =
+{
+    { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x80, 0x80, 0x80, 0x80 },
+    { 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x04, 0x05, 0x06, 0x07, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80 },
+    { 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80 },
+    { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80 },
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f }
+};
+
+__attribute__((target("sse4.2")))
+static inline int storePacked(int* out, __m128i values, int mask)
+{
+    __m128i control = _mm_load_si128((const __m128i*)packLanes[mask]);
+    _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(values, control));
+    return __builtin_popcount(mask);
+}
+
+// Bit t of the result is set if lane t of va equals any lane of vb.
+__attribute__((target("sse4.2")))
+static inline int matchLanes(__m128i va, __m128i vb)
+{
+    __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                     _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+        _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                     _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+    return _mm_movemask_ps(_mm_castsi128_ps(hits));
+}
+
+__attribute__((target("sse4.2")))
+static int mergeIntersectSse(const int* a, int na, const int* b, int nb, int* out,
+                             int room)
+{
+    int i = 0, j = 0, k = 0;
+    while(i + 4 <= na && j + 4 <= nb)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+        int mask = matchLanes(va, vb);
+        if(k + 4 <= room) // A full-width store stays inside out.
+            k += storePacked(out + k, va, mask);
+        else
+        {
+            for(int t = 0; t < 4; t++)
+            {
+                if(mask & (1 << t))
+                    out[k++] = a[i + t];
+            }
+        }
+
+        int amax = a[i + 3], bmax = b[j + 3]; // Retire whichever block
+        if(amax <= bmax)                      // cannot match anything
+            i += 4;                           // further along.
+        if(bmax <= amax)
+            j += 4;
+    }
+    return k + mergeIntersect(a + i, na - i, b + j, nb - j, out + k);
+}
+
+__attribute__((target("sse4.2")))
+static int mergeDifferenceSse(const int* a, int na, const int* b, int nb, int* out,
+                              int room)
+{
+    int i = 0, j = 0, k = 0;
+    while(i + 4 <= na && j + 4 <= nb)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        int matched = 0; // Lanes of va found in any block of b so far.
+        bool done = false;
+        while(!done)
+        {
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+            matched |= matchLanes(va, vb);
+            int amax = a[i + 3], bmax = b[j + 3];
+            if(amax > bmax) // Later blocks of b may still match va.
+            {
+                j += 4;
+                if(j + 4 > nb) // Settle va against b's last few ints.
+                {
+                    for(int t = 0; t < 4; t++)
+                    {
+                        if(matched & (1 << t))
+                            continue;
+                        while(j < nb && b[j] < a[i + t])
+                            j++;
+                        if(j < nb && b[j] == a[i + t])
+                            j++;
+                        else
+                            out[k++] = a[i + t];
+                    }
+                    i += 4;
+                    done = true;
+                }
+            }
+            else
+            {
+                if(k + 4 <= room) // A full-width store stays inside out.
+                    k += storePacked(out + k, va, ~matched & 0xF);
+                else
+                {
+                    for(int t = 0; t < 4; t++)
+                    {
+                        if((matched & (1 << t)) == 0)
+                            out[k++] = a[i + t];
+                    }
+                }
+                i += 4;
+                if(amax == bmax)
+                    j += 4;
+                done = true;
+            }
+        }
+    }
+    return k + mergeDifference(a + i, na - i, b + j, nb - j, out + k);
+}
+
+// Merges the ascending vectors va and vb (a bitonic network of
+// min/max steps), leaving the 4 smallest in lo and the 4 largest in
+// hi, each ascending.
+__attribute__((target("sse4.2")))
+static inline void mergeLanes(__m128i va, __m128i vb, __m128i& lo, __m128i& hi)
+{
+    __m128i tmp = _mm_min_epi32(va, vb);
+    hi = _mm_max_epi32(va, vb);
+    for(int round = 0; round < 3; round++)
+    {
+        tmp = _mm_alignr_epi8(tmp, tmp, 4);
+        lo = _mm_min_epi32(tmp, hi);
+        hi = _mm_max_epi32(tmp, hi);
+        tmp = lo;
+    }
+    lo = _mm_alignr_epi8(lo, lo, 4);
+}
+
+__attribute__((target("sse4.2")))
+static int mergeUnionSse(const int* a, int na, const int* b, int nb, int* out,
+                         int room)
+{
+    if(na < 4 || nb < 4)
+        return mergeUnion(a, na, b, nb, out);
+
+    int k = 0;
+    __m128i lo, hi;
+    mergeLanes(_mm_loadu_si128((const __m128i*)a),
+               _mm_loadu_si128((const __m128i*)b), lo, hi);
+    int i = 4, j = 4;
+    __m128i last = _mm_set1_epi32(_mm_cvtsi128_si32(lo) ^ 1); // Differs from lo's
+    for(;;)                                                  // first lane.
+    {
+        // A value common to a and b shows up twice in a row; keep
+        // only the lanes that differ from the lane before them.
+        __m128i before = _mm_alignr_epi8(lo, last, 12);
+        int repeats = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lo, before)));
+        if(k + 4 <= room) // A full-width store stays inside out.
+            k += storePacked(out + k, lo, ~repeats & 0xF);
+        else
+        {
+            int lanes[4] __attribute__((aligned(16)));
+            _mm_store_si128((__m128i*)lanes, lo);
+            for(int t = 0; t < 4; t++)
+            {
+                if((repeats & (1 << t)) == 0)
+                    out[k++] = lanes[t];
+            }
+        }
+        last = lo;
+
+        if(i + 4 > na || j + 4 > nb) // The other side's last few ints
+            break;                   // might sort before its next block.
+
+        __m128i next;
+        if(a[i] <= b[j]) // Take the block whose head is smaller, so that
+        {                // nothing still unread sorts before the next lo.
+            next = _mm_loadu_si128((const __m128i*)(a + i));
+            i += 4;
+        }
+        else
+        {
+            next = _mm_loadu_si128((const __m128i*)(b + j));
+            j += 4;
+        }
+        mergeLanes(next, hi, lo, hi);
+    }
+
+    // Finish hi and what is left of a and b with a scalar three-way
+    // merge that also skips repeats of the last value written.
+    int pending[4] __attribute__((aligned(16)));
+    _mm_store_si128((__m128i*)pending, hi);
+    int prev = out[k - 1];
+    int p = 0;
+    while(p < 4 || i < na || j < nb)
+    {
+        int v;
+        if(p < 4 && (i >= na || pending[p] <= a[i]) && (j >= nb || pending[p] <= b[j]))
+            v = pending[p++];
+        else if(i < na && (j >= nb || a[i] <= b[j]))
+            v = a[i++];
+        else
+            v = b[j++];
+        if(v != prev)
+        {
+            out[k++] = v;
+            prev = v;
+        }
+    }
+    return k;
+}
+
+#else
+
+static int mergeUnionSse(const int* a, int na, const int* b, int nb, int* out,
+                         int room)
+{
+    (void)room;
+    return mergeUnion(a, na, b, nb, out);
+}
+
+static int mergeIntersectSse(const int* a, int na, const int* b, int nb, int* out,
+                             int room)
+{
+    (void)room;
+    return mergeIntersect(a, na, b, nb, out);
+}
+
+static int mergeDifferenceSse(const int* a, int na, const int* b, int nb, int* out,
+                              int room)
+{
+    (void)room;
+    return mergeDifference(a, na, b, nb, out);
+}
+
+#endif
+
+int gallop(const int* a, int from, int na, int target)
+{
+    int step = 1;
+    int lo = from, hi = from; // Invariant: a[lo - 1] < target, if it exists.
+    while(hi < na && a[hi] < target)
+    {
+        lo = hi + 1;
+        // Exponential search brackets the answer... Both are kept in
+        // terms of na - from, so neither overflows for na near INT_MAX.
+        hi = (na - from > step) ? from + step : na;
+        step = (na - from - step > step) ? 2 * step : na - from;
+    }
+    return int(lower_bound(a + lo, a + hi, target) - a); // ...binary search finds it.
+}
+
+static int gallopUnion(const int* small, int ns, const int* big, int nb, int* out)
+{
+    int j = 0, k = 0;
+    for(int i = 0; i < ns; i++)
+    {
+        int at = gallop(big, j, nb, small[i]);
+        while(j < at)          // Copy the run of big that sorts
+            out[k++] = big[j++]; // before small[i] across as is.
+        out[k++] = small[i];
+        if(j < nb && big[j] == small[i])
+            j++; // Common to both, already written.
+    }
+    while(j < nb)
+        out[k++] = big[j++];
+    return k;
+}
+
+static int gallopSymmetricDifference(const int* small, int ns, const int* big,
+                                     int nb, int* out)
+{
+    int j = 0, k = 0;
+    for(int i = 0; i < ns; i++)
+    {
+        int at = gallop(big, j, nb, small[i]);
+        while(j < at)
+            out[k++] = big[j++];
+        if(j < nb && big[j] == small[i])
+            j++; // Common to both, so left out.
+        else
+            out[k++] = small[i];
+    }
+    while(j < nb)
+        out[k++] = big[j++];
+    return k;
+}
+
+static int gallopIntersect(const int* small, int ns, const int* big, int nb, int* out)
+{
+    int j = 0, k = 0;
+    for(int i = 0; i < ns && j < nb; i++)
+    {
+        j = gallop(big, j, nb, small[i]);
+        if(j < nb && big[j] == small[i])
+            out[k++] = small[i];
+    }
+    return k;
+}
+
+static int gallopDifference(const int* a, int na, const int* b, int nb, int* out)
+{
+    int k = 0;
+    if(na <= nb) // Walk a; keep what galloping through b does not find.
+    {
+        int j = 0;
+        for(int i = 0; i < na; i++)
+        {
+            j = gallop(b, j, nb, a[i]);
+            if(j == nb || b[j] != a[i])
+                out[k++] = a[i];
+        }
+    }
+    else // Walk b; copy across the runs of a between its values.
+    {
+        int i = 0;
+        for(int j = 0; j < nb && i < na; j++)
+        {
+            int at = gallop(a, i, na, b[j]);
+            while(i < at)
+                out[k++] = a[i++];
+            if(i < na && a[i] == b[j])
+                i++; // In both, so not in the difference.
+        }
+        while(i < na)
+            out[k++] = a[i++];
+    }
+    return k;
+}
+
+int sortedUnion(const int* a, int na, const int* b, int nb, int* out, int room)
+{
+    if(double(na) * GALLOP_RATIO < nb)
+        return gallopUnion(a, na, b, nb, out);
+    if(double(nb) * GALLOP_RATIO < na)
+        return gallopUnion(b, nb, a, na, out);
+    if(haveSse42())
+        return mergeUnionSse(a, na, b, nb, out, room >= 0 ? room : na + nb);
+    return mergeUnion(a, na, b, nb, out);
+}
+
+int sortedIntersect(const int* a, int na, const int* b, int nb, int* out,
+                    int room)
+{
+    if(double(na) * GALLOP_RATIO < nb)
+        return gallopIntersect(a, na, b, nb, out);
+    if(double(nb) * GALLOP_RATIO < na)
+        return gallopIntersect(b, nb, a, na, out);
+    if(haveSse42() && out != a)
+        return mergeIntersectSse(a, na, b, nb, out,
+                                 room >= 0 ? room : (na < nb ? na : nb));
+    return mergeIntersect(a, na, b, nb, out);
+}
+
+int sortedDifference(const int* a, int na, const int* b, int nb, int* out,
+                     int room)
+{
+    if(double(na) * GALLOP_RATIO < nb || double(nb) * GALLOP_RATIO < na)
+        return gallopDifference(a, na, b, nb, out);
+    if(haveSse42() && out != a)
+        return mergeDifferenceSse(a, na, b, nb, out, room >= 0 ? room : na);
+    return mergeDifference(a, na, b, nb, out);
+}
+
+int sortedSymmetricDifference(const int* a, int na, const int* b, int nb, int* out)
+{
+    if(double(na) * GALLOP_RATIO < nb)
+        return gallopSymmetricDifference(a, na, b, nb, out);
+    if(double(nb) * GALLOP_RATIO < na)
+        return gallopSymmetricDifference(b, nb, a, na, out);
+    return mergeSymmetricDifference(a, na, b, nb, out);
+}
+
+int sortedIntersectionSize(const int* a, int na, const int* b, int nb)
+{
+    if(double(nb) * GALLOP_RATIO < na) // Walk the smaller side.
+    {
+        const int* t = a; a = b; b = t;
+        int n = na; na = nb; nb = n;
+    }
+    int i = 0, j = 0, k = 0;
+    if(double(na) * GALLOP_RATIO < nb)
+    {
+        for(; i < na && j < nb; i++)
+        {
+            j = gallop(b, j, nb, a[i]);
+            if(j < nb && b[j] == a[i])
+                k++;
+        }
+        return k;
+    }
+    while(i < na && j < nb)
+    {   // Step past whichever is smaller (both, if they match).
+        int x = a[i], y = b[j];
+        k += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return k;
+}
+
+bool sortedIntersects(const int* a, int na, const int* b, int nb)
+{
+    if(nb < na) // Walk the smaller side.
+    {
+        const int* t = a; a = b; b = t;
+        int n = na; na = nb; nb = n;
+    }
+    int j = 0;
+    for(int i = 0; i < na && j < nb; i++)
+    {
+        j = gallop(b, j, nb, a[i]);
+        if(j < nb && b[j] == a[i])
+            return true;
+    }
+    return false;
+}
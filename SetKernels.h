@@ -0,0 +1,89 @@
+// FILE: SetKernels.h - header file for the array kernels behind IntSet
+// FUNCTIONS PROVIDED: the membership scan and the sorted-array set
+//                     algebra that IntSet (and anything else that
+//                     keeps ints in plain arrays) is built on.
+//
+// CONSTANT
+//   const int GALLOP_RATIO = ____
+//     Size ratio beyond which walking the smaller side of a set
+//     operation and galloping through the larger one beats a linear
+//     merge of the two.
+//
+// FUNCTIONS
+//   int scanFind(const int* a, int n, int target)
+//     Pre:  n >= 0.
+//     Post: The smallest i in [0, n) with a[i] == target is returned
+//           (-1 if there is none).
+//     Note: Compares 16, 8 or 4 ints per instruction (AVX-512F, AVX2
+//           or SSE2, whichever the CPU running the program supports)
+//           and falls back to a plain loop elsewhere.
+//   int gallop(const int* a, int from, int na, int target)
+//     Pre:  a[0..na) is strictly ascending and 0 <= from <= na.
+//     Post: The smallest i in [from, na) with a[i] >= target is
+//           returned (na if there is none). Steps of 1, 2, 4, ...
+//           bracket i first and a binary search then pins it down,
+//           so the cost is O(log(i - from)) rather than O(log na).
+//   int sortedUnion(const int* a, int na, const int* b, int nb,
+//                   int* out, int room = -1)
+//   int sortedIntersect(const int* a, int na, const int* b, int nb,
+//                       int* out, int room = -1)
+//   int sortedDifference(const int* a, int na, const int* b, int nb,
+//                        int* out, int room = -1)
+//   int sortedSymmetricDifference(const int* a, int na, const int* b,
+//                                 int nb, int* out)
+//     Pre:  a[0..na) and b[0..nb) are each strictly ascending; out
+//           has room for na + nb (sortedUnion and
+//           sortedSymmetricDifference), the smaller of na and nb
+//           (sortedIntersect) or na (sortedDifference) ints and
+//           does not overlap a or b, except that sortedIntersect and
+//           sortedDifference accept out == a (working in place).
+//           If room is given (>= 0), out need only have room for room
+//           ints, as long as that is at least the size of the result.
+//     Post: The ascending union, intersection, difference (a - b) or
+//           symmetric difference has been written to out in a single
+//           pass, and the # of ints written is returned.
+//     Note: When one side is more than GALLOP_RATIO times the size
+//           of the other, only the smaller side is walked and the
+//           larger is galloped through. Otherwise the two are merged
+//           linearly, 4 ints at a time with SSE4.2 where the CPU
+//           supports it (except for sortedSymmetricDifference, and
+//           unless out is a: the wide stores could overrun ints of a
+//           not yet read). The wide stores may leave scratch values
+//           in out past the ints returned, but never past its room
+//           (so room = the exact size of the result writes nothing
+//           else, for results placed side by side).
+//   int sortedIntersectionSize(const int* a, int na, const int* b,
+//                              int nb)
+//     Pre:  a[0..na) and b[0..nb) are each strictly ascending.
+//     Post: The # of ints in both a and b is returned (nothing is
+//           written anywhere); the sizes of the union, difference and
+//           symmetric difference follow from it and na and nb.
+//     Note: Gallops as sortedIntersect does; the linear merge has no
+//           data-dependent branches.
+//   bool sortedIntersects(const int* a, int na, const int* b, int nb)
+//     Pre:  a[0..na) and b[0..nb) are each strictly ascending.
+//     Post: true is returned if some int is in both a and b,
+//           otherwise false; the walk stops at the first one found.
+//     Note: Walks the smaller side and gallops through the larger, so
+//           it is never worse than a linear merge and much better
+//           when the sizes differ a lot.
+
+#ifndef SET_KERNELS_H
+#define SET_KERNELS_H
+
+const int GALLOP_RATIO = 32;
+
+int scanFind(const int* a, int n, int target);
+int gallop(const int* a, int from, int na, int target);
+int sortedUnion(const int* a, int na, const int* b, int nb, int* out,
+                int room = -1);
+int sortedIntersect(const int* a, int na, const int* b, int nb, int* out,
+                    int room = -1);
+int sortedDifference(const int* a, int na, const int* b, int nb, int* out,
+                     int room = -1);
+int sortedSymmetricDifference(const int* a, int na, const int* b, int nb,
+                              int* out);
+int sortedIntersectionSize(const int* a, int na, const int* b, int nb);
+bool sortedIntersects(const int* a, int na, const int* b, int nb);
+
+#endif
@@ -0,0 +1,1130 @@
+// FILE: TestIntSet.cpp
+//       A self-checking test program for the IntSet data type (and
+//       the set classes built on it). Runs
+//       every test below, writes a line to cout for each check that
+//       fails, and exits with status 1 if any did (0 otherwise).
+//       Usage: intset_test
+
+#include "IntSet.h"
+#include "ConcurrentIntSet.h"
+#include "RcuIntSet.h"
+#include "RoaringIntSet.h"
+#include "FrozenIntSet.h"
+#include "MemoryResource.h"
+#include "SerialFormat.h"
+#include <iostream>
+#include <cstddef>
+#include <climits>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+using namespace std;
+
+// A MemoryResource that counts what goes through it (on to
+// newDeleteResource()), so tests can tell how often IntSet allocates
+// and whether it gives everything back. Safe to share among threads.
+class CountingResource : public MemoryResource
+{
+public:
+   CountingResource() : allocations(0), live(0), liveBytes(0), peakBytes(0)
+   {}
+   void* allocate(size_t bytes, size_t alignment)
+   {
+      ++allocations;
+      ++live;
+      long now = liveBytes += long(bytes);
+      long peak = peakBytes;
+      while (now > peak && !peakBytes.compare_exchange_weak(peak, now))
+         ;
+      return newDeleteResource()->allocate(bytes, alignment);
+   }
+   void deallocate(void* p, size_t bytes, size_t alignment)
+   {
+      --live;
+      liveBytes -= long(bytes);
+      newDeleteResource()->deallocate(p, bytes, alignment);
+   }
+   atomic<long> allocations;   // # of allocate calls so far
+   atomic<long> live;          // # of blocks not yet deallocated
+   atomic<long> liveBytes;     // # of bytes in those blocks
+   atomic<long> peakBytes;     // The most liveBytes has been
+};
+
+int failures = 0;   // # of checks that have failed so far
+
+// PROTOTYPES for functions used by this test program:
+
+void check(bool ok, const char* test, const char* what);
+// Pre:  (none)
+// Post: If ok is false, the failure of check what in test has been
+//       written to cout and counted in failures.
+
+bool holdsExactly(const IntSet& is, int low, int high);
+// Pre:  low <= high + 1.
+// Post: true is returned if is holds every int from low through
+//       high and nothing else, otherwise false.
+
+void testDescendingAdds();
+// Pre:  (none)
+// Post: Adds of a long run of ints in descending (and, for
+//       comparison, ascending) order have been checked to give the
+//       right set while rebuilding its index only O(log n) times.
+
+void testConcurrentCopies();
+// Pre:  (none)
+// Post: Several threads copying (by construction and by assignment)
+//       the same const IntSet at once have been checked to get equal
+//       copies, and to leave exactly one count of the IntSets sharing
+//       its array, freed with the last of them.
+
+void testResourceSemantics();
+// Pre:  (none)
+// Post: IntSets have been checked to keep their own MemoryResource
+//       through assignment (copy and move) from IntSets using
+//       another one, so that a resource that goes away first takes
+//       none of their arrays with it; copies and the constructors
+//       taking ints have been checked to allocate where they should.
+
+void testConcurrentReaders();
+// Pre:  (none)
+// Post: Several threads running const member functions (DumpData,
+//       dumpFast, isSubsetOf, serialize, the set operations, copying)
+//       on the same IntSets at once, while those hold tombstones, have
+//       been checked to get the same results as one thread alone, and
+//       to leave the IntSets unchanged.
+
+void testCorruptHeaders();
+// Pre:  (none)
+// Post: deserialize has been checked to reject (returning false,
+//       with failbit set and the IntSet unchanged) headers whose
+//       count is far beyond the bytes that follow, and truncated
+//       data; and to still read back large IntSets in either
+//       encoding.
+
+void testSortedMerges();
+// Pre:  (none)
+// Post: unionInPlace and symmetricDifferenceInPlace on SORTED_ORDER
+//       IntSets have been checked against a plain merge of the
+//       same values, to allocate nothing when the result fits the
+//       IntSet's array (or INLINE_CAPACITY), and to hold no dynamic
+//       array once the result fits INLINE_CAPACITY.
+
+void testConcurrentIntSet();
+// Pre:  (none)
+// Post: A ConcurrentIntSet has been checked against an IntSet given
+//       the same adds and removes; and, with writers and readers
+//       running at once, every snapshot has been checked to be the
+//       set as it was at one moment (and a proper SORTED_ORDER
+//       IntSet), ending with exactly what the writers left.
+
+void testRcuIntSet();
+// Pre:  (none)
+// Post: An RcuIntSet has been checked against an IntSet given the same
+//       adds and removes; and, with a writer running, readers have
+//       been checked to see only sets the writer published, also
+//       while every reader slot is held by other threads (readers
+//       beyond MAX_READER_THREADS must not wait for one).
+
+void testLoadFrom();
+// Pre:  (none)
+// Post: loadFrom has been checked to read nothing from a stream that
+//       has already failed, and to read malformed text to its end
+//       (returning false, with failbit set and the IntSet unchanged).
+
+void testRoaringIntSet();
+// Pre:  (none)
+// Post: A RoaringIntSet has been checked against a SORTED_ORDER
+//       IntSet given the same adds and removes (over sparse, dense
+//       and run-heavy chunks, so every kind of container and the
+//       switches between them are used), and its set operations
+//       against the IntSet's; and several threads reading it at once,
+//       while another changes a copy of it, have been checked to get
+//       the same results as one thread alone.
+
+void testFrozenIntSet();
+// Pre:  The current directory can be written to.
+// Post: A FrozenIntSet has been checked against the IntSet it was
+//       written from (with tombstones, and against other IntSets in
+//       either order), to refuse files it cannot use in place; and
+//       several threads querying one FrozenIntSet, and opening the
+//       file afresh while another thread replaces it by rename, have
+//       been checked to see exactly the old or the new set each time.
+//       The files made along the way have been removed.
+
+template <class Set>
+string dumpOf(const Set& set);
+// Pre:  (none)
+// Post: What set.DumpData writes is returned.
+
+void testUnionAllSizing();
+// Pre:  (none)
+// Post: unionAll of many heavily overlapping IntSets (in either order)
+//       has been checked to give what chained unionWiths give, never
+//       to size its array for all of the sets together, and to return
+//       a result fitted to its size.
+
+void testGrowthPolicies();
+// Pre:  (none)
+// Post: The built-in growth policies have been checked to saturate at
+//       INT_MAX rather than overflow, and an IntSet whose policy
+//       gives a negative capacity to still take every add.
+
+int negativePolicy(int current_capacity);
+// Pre:  (none)
+// Post: INT_MIN is returned, as by a policy that has overflowed.
+
+string header(unsigned flags, unsigned count, unsigned payload);
+// Pre:  (none)
+// Post: A 16-byte serialize header (see SerialFormat.h) with the
+//       given flags, # of elements and # of payload bytes is
+//       returned.
+
+int main()
+{
+   testDescendingAdds();
+   testConcurrentCopies();
+   testResourceSemantics();
+   testConcurrentReaders();
+   testCorruptHeaders();
+   testSortedMerges();
+   testConcurrentIntSet();
+   testRcuIntSet();
+   testLoadFrom();
+   testRoaringIntSet();
+   testFrozenIntSet();
+   testUnionAllSizing();
+   testGrowthPolicies();
+
+   if (failures == 0)
+      cout << "All IntSet tests passed." << endl;
+   return failures == 0 ? 0 : 1;
+}
+
+void check(bool ok, const char* test, const char* what)
+{
+   if (!ok)
+   {
+      cout << test << ": FAILED: " << what << endl;
+      ++failures;
+   }
+}
+
+bool holdsExactly(const IntSet& is, int low, int high)
+{
+   if (is.size() != high - low + 1)
+      return false;
+   for (long long v = low; v <= high; ++v)   // (high may be INT_MAX)
+      if (!is.contains(int(v)))
+         return false;
+   return true;   // Right size, so nothing else is in it.
+}
+
+void testDescendingAdds()
+{
+   const int n = 80000;
+   const char* test = "testDescendingAdds";
+
+   // Each rebuild of the index allocates a new table, so a bound on
+   // the allocations is a bound on the rebuilds (and on the time: a
+   // rebuild on every add, as a window that only grows upward would
+   // need here, is O(n^2)).
+   CountingResource down;
+   {
+      IntSet is(1, &down);
+      for (int v = n; v >= 1; --v)
+         is.add(v);
+      check(holdsExactly(is, 1, n), test, "descending adds give 1..n");
+      check(down.allocations < 200, test,
+            "descending adds rebuild the index O(log n) times");
+   }
+   check(down.live == 0, test, "everything allocated is given back");
+
+   CountingResource up;
+   {
+      IntSet is(1, &up);
+      for (int v = 1; v <= n; ++v)
+         is.add(v);
+      check(holdsExactly(is, 1, n), test, "ascending adds give 1..n");
+      check(up.allocations < 200, test,
+            "ascending adds rebuild the index O(log n) times");
+   }
+
+   // Around the ends of the range of int, where the window is clipped.
+   IntSet low, high;
+   for (int i = 0; i < 1000; ++i)
+   {
+      low.add(INT_MIN + 999 - i);
+      high.add(INT_MAX - 999 + i);
+   }
+   check(holdsExactly(low, INT_MIN, INT_MIN + 999), test,
+         "descending adds down to INT_MIN");
+   check(holdsExactly(high, INT_MAX - 999, INT_MAX), test,
+         "ascending adds up to INT_MAX");
+}
+
+void testConcurrentCopies()
+{
+   const int threads = 8;
+   const int rounds = 50;
+   const char* test = "testConcurrentCopies";
+
+   CountingResource counted;
+   atomic<int> unequal(0);
+   long leftOver = 0;
+   for (int round = 0; round < rounds; ++round)
+   {   // A new source each round, not yet copied, so that the threads
+       // race to create the count of IntSets sharing its array.
+      {
+         IntSet source(1, &counted);
+         for (int v = 0; v < 1000; ++v)
+            source.add(v * 7 + round);
+         const IntSet& shared = source;
+         vector<thread> copiers;
+         for (int t = 0; t < threads; ++t)
+            copiers.push_back(thread([&shared, &counted, &unequal]
+            {
+               for (int i = 0; i < 20; ++i)
+               {
+                  IntSet byConstruction(shared);
+                  IntSet byAssignment(1, &counted);
+                  byAssignment = shared;
+                  if (!(byConstruction == shared && byAssignment == shared))
+                     ++unequal;
+               }
+            }));
+         for (int t = 0; t < threads; ++t)
+            copiers[t].join();
+      }
+      leftOver += counted.live;
+   }
+   check(unequal == 0, test, "every copy equals the source");
+   check(leftOver == 0, test, "everything allocated is given back");
+}
+
+void testResourceSemantics()
+{
+   const char* test = "testResourceSemantics";
+   int values[100];
+   for (int i = 0; i < 100; ++i)
+      values[i] = 3 * i;
+
+   CountingResource longLived;
+   IntSet kept(1, &longLived), moved(1, &longLived);
+   {
+      MonotonicArena arena;
+      IntSet temp(values, 100, &arena);
+      check(temp.memoryResource() == &arena, test,
+            "the (values, n) constructor takes a resource");
+      kept = temp;
+      moved = std::move(temp);
+      check(kept.memoryResource() == &longLived &&
+            moved.memoryResource() == &longLived, test,
+            "assignment keeps the destination's resource");
+      check(temp.size() == 100, test,
+            "a move between resources copies, leaving the source");
+
+      IntSet copy(temp);
+      check(copy.memoryResource() == newDeleteResource(), test,
+            "the copy constructor allocates from the default resource");
+      IntSet inArena(kept, &arena);
+      check(inArena.memoryResource() == &arena && inArena == kept, test,
+            "the copy constructor takes a resource");
+
+      IntSet listed({ 5, 6, 7 }, &arena);
+      IntSet ranged(values, values + 100, &arena);
+      check(listed.memoryResource() == &arena && listed.size() == 3 &&
+            ranged.memoryResource() == &arena && ranged == kept, test,
+            "the list and iterator constructors take a resource");
+   }   // The arena gives back everything it handed out here.
+
+   IntSet expected(values, 100);
+   check(kept == expected && moved == expected, test,
+         "assigned IntSets outlive the source's resource");
+   kept.add(-1);   // Writes to the arrays, which must be kept's own.
+   moved.remove(0);
+   check(kept.size() == 101 && moved.size() == 99, test,
+         "assigned IntSets can still be changed");
+
+   long before = longLived.allocations;
+   IntSet sameResource(1, &longLived);
+   sameResource = kept;
+   check(longLived.allocations == before + 1, test,   // (for the count
+         "copy assignment within one resource shares the array"); // only)
+   sameResource = std::move(moved);
+   check(moved.isEmpty() && sameResource.size() == 99, test,
+         "move assignment within one resource takes the arrays over");
+}
+
+void testConcurrentReaders()
+{
+   const int threads = 8;
+   const char* test = "testConcurrentReaders";
+
+   // a and b hold tombstones (too few to compact); the expected
+   // results come from identical IntSets, so a and b are untouched
+   // until the readers start.
+   IntSet a, b, aAlike, bAlike;
+   for (int v = 0; v < 3000; ++v)
+   {
+      a.add(v * 5);
+      aAlike.add(v * 5);
+      b.add(v * 5);
+      bAlike.add(v * 5);
+      b.add(v * 5 + 1);
+      bAlike.add(v * 5 + 1);
+   }
+   for (int v = 0; v < 3000; v += 3)
+   {
+      a.remove(v * 5);
+      aAlike.remove(v * 5);
+   }
+   b.remove(1);
+   bAlike.remove(1);
+
+   ostringstream dump, bytes;
+   aAlike.DumpData(dump);
+   aAlike.serialize(bytes);
+   const string expectedDump = dump.str();
+   const string expectedBytes = bytes.str();
+   const IntSet expectedUnion = aAlike.unionWith(bAlike);
+   const int expectedSize = aAlike.size();
+
+   atomic<int> wrong(0);
+   vector<thread> readers;
+   for (int t = 0; t < threads; ++t)
+      readers.push_back(thread([&a, &b, &wrong, &expectedDump,
+                                &expectedBytes, &expectedUnion]
+      {
+         for (int i = 0; i < 20; ++i)
+         {
+            ostringstream dump, fast, bytes;
+            a.DumpData(dump);
+            a.dumpFast(fast);
+            a.serialize(bytes);
+            IntSet copy(a);
+            if (dump.str() != expectedDump || fast.str() != expectedDump ||
+                bytes.str() != expectedBytes ||
+                !a.isSubsetOf(b) || !(copy == a) ||
+                !(a.unionWith(b) == expectedUnion) ||
+                a.intersect(b).size() != a.size() ||
+                !a.subtract(b).isEmpty() ||
+                a.intersectionSize(b) != a.size() || !a.intersects(b))
+               ++wrong;
+         }
+      }));
+   for (int t = 0; t < threads; ++t)
+      readers[t].join();
+   check(wrong == 0, test, "every reader gets the single-thread results");
+   check(a.size() == expectedSize, test, "the readers change nothing");
+}
+
+template <class Set>
+string dumpOf(const Set& set)
+{
+   ostringstream out;
+   set.DumpData(out);
+   return out.str();
+}
+
+string header(unsigned flags, unsigned count, unsigned payload)
+{
+   string h(reinterpret_cast<const char*>(SERIAL_MAGIC), 4);
+   h += char(SERIAL_VERSION);
+   h += char(flags);
+   h += string(2, '\0');
+   for (int shift = 0; shift < 32; shift += 8)
+      h += char((count >> shift) & 0xFF);
+   for (int shift = 0; shift < 32; shift += 8)
+      h += char((payload >> shift) & 0xFF);
+   return h;
+}
+
+void testCorruptHeaders()
+{
+   const char* test = "testCorruptHeaders";
+   IntSet is({ 1, 2, 3 });
+
+   // Counts of up to 2^31 - 1 elements, followed by a few bytes only.
+   const string bogus[] =
+   {
+      header(SERIAL_DELTA_VARINT, 0x7FFFFFFF, 0x7FFFFFFF) + string(64, '\2'),
+      header(SERIAL_DELTA_VARINT | SERIAL_SORTED, 0x7FFFFFFF, 0xFFFFFFFF),
+      header(0, 0x3FFFFFFF, 0xFFFFFFFC) + string(64, '\0'),
+      header(SERIAL_SORTED, 0x20000000, 0x80000000)
+   };
+   for (size_t i = 0; i < sizeof bogus / sizeof bogus[0]; ++i)
+   {
+      istringstream in(bogus[i]);
+      bool loaded = true;
+      try
+      {
+         loaded = is.deserialize(in);
+      }
+      catch (const bad_alloc&)
+      {
+         check(false, test, "a corrupt count does not throw bad_alloc");
+      }
+      check(!loaded && in.fail(), test, "a corrupt count is rejected");
+      check(is == IntSet({ 1, 2, 3 }), test,
+            "a rejected stream leaves the IntSet unchanged");
+   }
+
+   // Large enough that the array has to grow while decoding.
+   vector<int> values;
+   for (int v = 0; v < 200000; ++v)
+      values.push_back(v * 37 % 1000003);
+   IntSet big(values.begin(), values.end());
+   IntSet sortedBig(big);
+   sortedBig.setOrder(IntSet::SORTED_ORDER);
+   for (int e = 0; e < 2; ++e)
+   {
+      IntSet::Encoding encoding =
+         e == 0 ? IntSet::RAW_ENCODING : IntSet::DELTA_VARINT_ENCODING;
+      ostringstream out, sortedOut;
+      big.serialize(out, encoding);
+      sortedBig.serialize(sortedOut, encoding);
+
+      IntSet back, sortedBack;
+      istringstream in(out.str()), sortedIn(sortedOut.str());
+      check(back.deserialize(in) && back == big, test,
+            "a large IntSet reads back");
+      check(sortedBack.deserialize(sortedIn) && sortedBack == sortedBig &&
+            sortedBack.order() == IntSet::SORTED_ORDER, test,
+            "a large sorted IntSet reads back");
+
+      ostringstream dumped, backDumped;
+      big.DumpData(dumped);
+      back.DumpData(backDumped);
+      check(dumped.str() == backDumped.str(), test,
+            "the elements read back are in the same order");
+
+      // Cut short: in the middle of the elements, and of the checksum.
+      const string whole = out.str();
+      const size_t cuts[] = { 16, whole.size() / 2, whole.size() - 2 };
+      for (int c = 0; c < 3; ++c)
+      {
+         istringstream truncated(whole.substr(0, cuts[c]));
+         check(!is.deserialize(truncated) && truncated.fail(), test,
+               "truncated data is rejected");
+      }
+   }
+   check(is == IntSet({ 1, 2, 3 }), test,
+         "rejected data leaves the IntSet unchanged");
+}
+
+void testSortedMerges()
+{
+   const char* test = "testSortedMerges";
+   CountingResource counted;
+
+   IntSet one(1, &counted), other(1, &counted);
+   one.setOrder(IntSet::SORTED_ORDER);
+   one.add(5);
+   other.add(7);   // INSERTION_ORDER: sorted on the side.
+   long before = counted.allocations;
+   for (int round = 0; round < 100; ++round)
+   {
+      one.unionInPlace(other);
+      one.symmetricDifferenceInPlace(other);
+   }
+   check(counted.allocations == before && one.size() == 1 &&
+         one.contains(5), test, "1-element merges allocate nothing");
+
+   // A big set shrinking to a few values goes back into the IntSet
+   // itself (letting its array go); growing allocates exactly once.
+   IntSet big(1, &counted), most(1, &counted);
+   big.setOrder(IntSet::SORTED_ORDER);
+   for (int i = 0; i < 1000; ++i)
+   {
+      big.add(i);
+      if (i >= 3)
+         most.add(i);
+   }
+   long liveBefore = counted.live;
+   big.symmetricDifferenceInPlace(most);
+   check(holdsExactly(big, 0, 2), test, "a symmetric difference");
+   check(counted.live < liveBefore, test,
+         "a result fitting INLINE_CAPACITY lets the array go");
+   IntSet widen({ -1, 3 }, &counted);
+   before = counted.allocations;
+   big.unionInPlace(widen);
+   check(holdsExactly(big, -1, 3) && counted.allocations == before,
+         test, "a small union stays in the IntSet itself");
+   most.setOrder(IntSet::SORTED_ORDER);
+   before = counted.allocations;
+   big.unionInPlace(most);
+   check(holdsExactly(big, -1, 999) &&
+         counted.allocations == before + 1, test,
+         "a union that has to grow allocates its array once");
+
+   // Against a plain merge, for overlaps of every kind and both of the
+   // other set's orders.
+   unsigned seed = 12345;
+   for (int round = 0; round < 200; ++round)
+   {
+      vector<bool> inA(200, false), inB(200, false);
+      IntSet a, b;
+      a.setOrder(IntSet::SORTED_ORDER);
+      if (round % 2 == 0)
+         b.setOrder(IntSet::SORTED_ORDER);
+      int span = 1 + round;
+      int na = round % 13 == 0 ? 0 : int(seed % 40);
+      for (int k = 0; k < 3 * na + round % 7; ++k)
+      {
+         seed = seed * 1103515245 + 12345;
+         int v = int((seed >> 8) % unsigned(span));
+         if (k < na)
+         {
+            a.add(v);
+            inA[v] = true;
+         }
+         else
+         {
+            b.add(v);
+            inB[v] = true;
+         }
+      }
+      IntSet u(a), x(a);
+      u.unionInPlace(b);
+      x.symmetricDifferenceInPlace(b);
+      bool same = true;
+      int nu = 0, nx = 0;
+      for (int v = 0; v < 200; ++v)
+      {
+         nu += inA[v] || inB[v];
+         nx += inA[v] != inB[v];
+         same = same && u.contains(v) == (inA[v] || inB[v]) &&
+                x.contains(v) == (inA[v] != inB[v]);
+      }
+      check(same && u.size() == nu && x.size() == nx, test,
+            "results match a plain merge");
+   }
+}
+
+void testConcurrentIntSet()
+{
+   const int writers = 4;
+   const int perWriter = 5000;
+   const char* test = "testConcurrentIntSet";
+
+   ConcurrentIntSet shared(5);
+   IntSet model;
+   unsigned seed = 99;
+   bool same = true;
+   for (int i = 0; i < 20000; ++i)
+   {
+      seed = seed * 1103515245 + 12345;
+      int v = int((seed >> 8) % 3000U) - 1500;
+      if (seed % 3 == 0)
+         same = same && shared.remove(v) == model.remove(v);
+      else
+         same = same && shared.add(v) == model.add(v);
+      same = same && shared.contains(v) == model.contains(v);
+   }
+   IntSet snap = shared.snapshot();
+   check(same && shared.size() == model.size(), test,
+         "add, remove, contains and size match an IntSet");
+   check(snap == model && snap.fingerprint() == model.fingerprint() &&
+         snap.order() == IntSet::SORTED_ORDER, test,
+         "a snapshot equals the IntSet");
+   model.setOrder(IntSet::SORTED_ORDER);
+   ostringstream dumped, expected;
+   shared.DumpData(dumped);
+   model.DumpData(expected);
+   check(dumped.str() == expected.str(), test,
+         "DumpData writes the elements in ascending order");
+   shared.reset();
+   check(shared.isEmpty() && shared.snapshot().isEmpty(), test,
+         "reset empties every shard");
+
+   // Writer w adds w, w + writers, w + 2 * writers, ... in that order
+   // (removing each a while later), so a set caught at one moment has
+   // a contiguous run of each writer's values.
+   atomic<bool> done(false);
+   atomic<int> wrong(0);
+   vector<thread> workers;
+   for (int w = 0; w < writers; ++w)
+      workers.push_back(thread([w, &shared]
+      {
+         for (int k = 0; k < perWriter; ++k)
+         {
+            shared.add(w + k * writers);
+            if (k >= 100)
+               shared.remove(w + (k - 100) * writers);
+         }
+      }));
+   for (int r = 0; r < 2; ++r)
+      workers.push_back(thread([&shared, &done, &wrong]
+      {
+         while (!done)
+         {
+            IntSet snap = shared.snapshot();
+            vector<int> first(writers, -1), last(writers, -1);
+            vector<int> held(writers, 0);
+            for (int v = 0; v < writers * perWriter; ++v)
+               if (snap.contains(v))
+               {
+                  int w = v % writers, k = v / writers;
+                  if (first[w] == -1)
+                     first[w] = k;
+                  last[w] = k;
+                  ++held[w];
+               }
+            int total = 0;
+            for (int w = 0; w < writers; ++w)
+            {
+               total += held[w];
+               if (held[w] > 0 && last[w] - first[w] + 1 != held[w])
+                  ++wrong;
+            }
+            if (total != snap.size() || snap.order() != IntSet::SORTED_ORDER)
+               ++wrong;
+         }
+      }));
+   for (int w = 0; w < writers; ++w)
+      workers[w].join();
+   done = true;
+   for (size_t t = writers; t < workers.size(); ++t)
+      workers[t].join();
+   check(wrong == 0, test, "every snapshot is the set at one moment");
+
+   IntSet left;
+   for (int w = 0; w < writers; ++w)
+      for (int k = perWriter - 100; k < perWriter; ++k)
+         left.add(w + k * writers);
+   check(shared.snapshot() == left && shared.size() == left.size(), test,
+         "the writers' adds and removes all take effect");
+}
+
+void testRcuIntSet()
+{
+   const int window = 50;   // The writer keeps this many values at most.
+   const char* test = "testRcuIntSet";
+
+   RcuIntSet rcu;
+   IntSet model;
+   unsigned seed = 7;
+   bool same = true;
+   for (int i = 0; i < 5000; ++i)
+   {
+      seed = seed * 1103515245 + 12345;
+      int v = int((seed >> 8) % 400U) - 200;
+      if (seed % 3 == 0)
+         same = same && rcu.remove(v) == model.remove(v);
+      else
+         same = same && rcu.add(v) == model.add(v);
+      same = same && rcu.contains(v) == model.contains(v);
+   }
+   ostringstream dumped, expected;
+   rcu.DumpData(dumped);
+   model.DumpData(expected);
+   check(same && rcu.size() == model.size() && rcu.snapshot() == model,
+         test, "add, remove, contains and size match an IntSet");
+   check(dumped.str() == expected.str(), test,
+         "DumpData keeps the IntSet's order");
+   rcu.reset();
+   check(rcu.isEmpty(), test, "reset empties it");
+
+   // Threads that hold every reader slot until told to let go.
+   atomic<int> holding(0);
+   atomic<bool> letGo(false);
+   vector<thread> holders;
+   for (int h = 0; h < RcuIntSet::MAX_READER_THREADS; ++h)
+      holders.push_back(thread([&rcu, &holding, &letGo]
+      {
+         rcu.contains(0);
+         ++holding;
+         while (!letGo)
+            this_thread::sleep_for(chrono::milliseconds(1));
+      }));
+
+   // The writer adds k and removes k - window, for k = 0, 1, ..., so
+   // every published set is a run of at most window + 1 values.
+   atomic<bool> written(false);
+   atomic<int> wrong(0), finished(0);
+   vector<thread> workers;
+   workers.push_back(thread([&rcu, &written, window]
+   {
+      for (int k = 0; k < 3000; ++k)
+      {
+         rcu.add(k);
+         if (k >= window)
+            rcu.remove(k - window);
+      }
+      written = true;
+   }));
+   for (int r = 0; r < 4; ++r)
+      workers.push_back(thread([&rcu, &written, &wrong, &finished, window]
+      {
+         do
+         {
+            IntSet seen = rcu.snapshot();
+            int low = INT_MAX, high = INT_MIN;
+            for (int v = 0; v < 3000; ++v)
+               if (seen.contains(v))
+               {
+                  low = min(low, v);
+                  high = max(high, v);
+               }
+            if (!seen.isEmpty() && (high - low + 1 != seen.size() ||
+                                    seen.size() > window + 1))
+               ++wrong;
+            if (rcu.size() > window + 1)
+               ++wrong;
+         } while (!written);
+         ++finished;
+      }));
+
+   // Readers without a slot must finish while the holders still hold
+   // theirs; the holders are let go either way, so a failure ends.
+   chrono::steady_clock::time_point giveUp =
+      chrono::steady_clock::now() + chrono::seconds(30);
+   while ((holding < RcuIntSet::MAX_READER_THREADS || finished < 4) &&
+          chrono::steady_clock::now() < giveUp)
+      this_thread::sleep_for(chrono::milliseconds(5));
+   check(finished == 4, test, "readers beyond the slots do not wait");
+   letGo = true;
+   for (size_t t = 0; t < holders.size(); ++t)
+      holders[t].join();
+   for (size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+   check(wrong == 0, test, "readers see only published sets");
+   check(rcu.size() == window && rcu.contains(2999) &&
+         !rcu.contains(2999 - window), test,
+         "the writer's adds and removes all take effect");
+}
+
+void testLoadFrom()
+{
+   const char* test = "testLoadFrom";
+   IntSet is({ 1, 2, 3 });
+   const IntSet before(is);
+
+   istringstream failed("4 5 6");
+   failed.setstate(ios::failbit);
+   check(!is.loadFrom(failed) && failed.fail() && is == before, test,
+         "a failed stream is rejected");
+   failed.clear();
+   int next = 0;
+   check(failed >> next && next == 4, test,
+         "a failed stream is not read from");
+
+   string text = "4 5 x 6";
+   for (int i = 0; i < 100000; ++i)   // Past the first chunk read.
+      text += " 7";
+   istringstream malformed(text + " 8");
+   check(!is.loadFrom(malformed) && malformed.fail() && is == before,
+         test, "malformed text is rejected");
+   malformed.clear();
+   check(malformed.peek() == EOF, test,
+         "malformed text is still read to the end");
+
+   istringstream good("9 -10 9\n11");
+   check(is.loadFrom(good) && good.eof() && !good.fail() &&
+         is == IntSet({ 9, -10, 11 }), test, "good text is loaded");
+}
+
+void testRoaringIntSet()
+{
+   const int threads = 8;
+   const char* test = "testRoaringIntSet";
+
+   // Phase p draws from chunks of one kind: p == 0 sparse values all
+   // over (array containers), p == 1 most of two chunks (bitmaps),
+   // p == 2 long runs (run containers); removes then thin each out.
+   RoaringIntSet r1, r2;
+   IntSet m1, m2;
+   m1.setOrder(IntSet::SORTED_ORDER);
+   m2.setOrder(IntSet::SORTED_ORDER);
+   unsigned seed = 4242;
+   bool same = true;
+   for (int p = 0; p < 3; ++p)
+      for (int i = 0; i < 30000; ++i)
+      {
+         seed = seed * 1103515245 + 12345;
+         unsigned pick = seed >> 4;
+         int v;
+         if (p == 0)
+            v = int(pick * 2654435761U);
+         else if (p == 1)
+            v = int(pick % 131072U) - 65536;
+         else
+            v = (int(pick % 64U) << 16) + int(i % 2000) + (i / 2000) * 3000;
+         bool toFirst = i / 1000 % 2 == 0;
+         RoaringIntSet& r = toFirst ? r1 : r2;
+         IntSet& m = toFirst ? m1 : m2;
+         if (p < 2 ? i % 5 == 4 : i % 97 == 96)
+            same = same && r.remove(v) == m.remove(v);
+         else
+            same = same && r.add(v) == m.add(v);
+         same = same && r.contains(v) == m.contains(v) &&
+                r.size() == m.size();
+      }
+   for (int v = -65536; v < 65536; ++v)   // Bitmaps back to arrays.
+      if (v % 20 != 0)
+         same = same && r1.remove(v) == m1.remove(v);
+   for (int edge = 0; edge < 2; ++edge)
+   {
+      int v = edge == 0 ? INT_MIN : INT_MAX;
+      same = same && r1.add(v) == m1.add(v) && r1.contains(v);
+   }
+   check(same, test, "add, remove, contains and size match an IntSet");
+   check(dumpOf(r1) == dumpOf(m1) && dumpOf(r2) == dumpOf(m2), test,
+         "DumpData writes the elements in ascending order");
+   check(dumpOf(r1.unionWith(r2)) == dumpOf(m1.unionWith(m2)) &&
+         dumpOf(r1.intersect(r2)) == dumpOf(m1.intersect(m2)) &&
+         dumpOf(r1.subtract(r2)) == dumpOf(m1.subtract(m2)) &&
+         dumpOf(r2.subtract(r1)) == dumpOf(m2.subtract(m1)), test,
+         "the set operations match an IntSet's");
+   check(r1.isSubsetOf(r1.unionWith(r2)) == true &&
+         r1.isSubsetOf(r2) == m1.isSubsetOf(m2) &&
+         r1.intersect(r2).isSubsetOf(r2) && r1 == r1.unionWith(r1) &&
+         !(r1 == r2), test, "isSubsetOf and operator== match an IntSet's");
+
+   // Readers share r1 while a writer changes a copy of it.
+   const string expectedDump = dumpOf(r1);
+   const string expectedUnion = dumpOf(m1.unionWith(m2));
+   const int expectedSize = r1.size();
+   atomic<int> wrong(0);
+   vector<thread> workers;
+   workers.push_back(thread([&r1]
+   {
+      RoaringIntSet copy(r1);
+      for (int v = -100000; v < 100000; ++v)
+         if (v % 3 == 0)
+            copy.remove(v);
+         else
+            copy.add(v);
+      RoaringIntSet assigned;
+      assigned = r1;
+      assigned.reset();
+   }));
+   for (int t = 0; t < threads; ++t)
+      workers.push_back(thread([&r1, &r2, &m1, &wrong, &expectedDump,
+                                &expectedUnion, expectedSize]
+      {
+         for (int i = 0; i < 5; ++i)
+         {
+            if (dumpOf(r1) != expectedDump || r1.size() != expectedSize ||
+                dumpOf(r1.unionWith(r2)) != expectedUnion ||
+                !r1.intersect(r2).isSubsetOf(r1))
+               ++wrong;
+            for (int v = -70000; v < 70000; v += 7)
+               if (r1.contains(v) != m1.contains(v))
+                  ++wrong;
+         }
+      }));
+   for (size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+   check(wrong == 0, test, "every reader gets the single-thread results");
+   check(dumpOf(r1) == expectedDump, test,
+         "changing a copy leaves the original as it was");
+}
+
+void testFrozenIntSet()
+{
+   const char* path = "TestIntSet.frozen";
+   const char* spare = "TestIntSet.frozen.new";
+   const int threads = 6;
+   const char* test = "testFrozenIntSet";
+
+   unsigned seed = 31337;
+   bool same = true;
+   FrozenIntSet frozen;
+   for (int round = 0; round < 40; ++round)
+   {
+      IntSet a, b;
+      if (round % 3 == 0)
+         b.setOrder(IntSet::SORTED_ORDER);
+      int n = round < 20 ? round * 3 : round * 200;
+      for (int i = 0; i < 2 * n; ++i)
+      {
+         seed = seed * 1103515245 + 12345;
+         int v = int((seed >> 8) % 4000U) - 2000;
+         if (i < n)
+            a.add(v);
+         else
+            b.add(v);
+      }
+      for (int v = -2000; v < 2000; v += 7)   // Tombstones, if indexed.
+         a.remove(v);
+      same = same && FrozenIntSet::write(a, path) &&
+             frozen.open(path, round % 2 == 0) && frozen.size() == a.size();
+      for (int v = -2010; v < 2010; ++v)
+         same = same && frozen.contains(v) == a.contains(v);
+      same = same && frozen.isSubsetOf(b) == a.isSubsetOf(b) &&
+             frozen.isSubsetOf(a) &&
+             frozen.intersectionSize(b) == a.intersectionSize(b) &&
+             frozen.unionSize(b) == a.unionSize(b) &&
+             frozen.differenceSize(b) == a.differenceSize(b) &&
+             frozen.jaccard(b) == a.jaccard(b) &&
+             frozen.intersects(b) == a.intersects(b);
+   }
+   check(same, test, "every query matches the IntSet written");
+
+   IntSet small({ 3, 1, 2 });
+   {
+      ofstream varint(spare, ios::binary);
+      small.serialize(varint);   // DELTA_VARINT_ENCODING: not usable.
+   }
+   check(!frozen.open(spare) && !frozen.isOpen() && frozen.isEmpty(), test,
+         "a varint file is refused");
+   FrozenIntSet::write(small, spare);
+   {
+      fstream corrupt(spare, ios::binary | ios::in | ios::out);
+      corrupt.seekp(SERIAL_HEADER_BYTES + 1);
+      corrupt.put(9);
+   }
+   check(frozen.open(spare) && !frozen.open(spare, true), test,
+         "a bad checksum is caught when verifying");
+   check(!frozen.open("TestIntSet.missing") && frozen.size() == 0 &&
+         !frozen.contains(1), test, "a missing file is refused");
+
+   // Readers query one FrozenIntSet, and open their own, while the
+   // file alternates between two sets (each written aside and renamed
+   // over it, as FrozenIntSet.h says to).
+   IntSet odd, even;
+   for (int v = 0; v < 20000; ++v)
+      (v % 2 == 0 ? even : odd).add(v * 3);
+   even.add(-1);
+   FrozenIntSet::write(odd, path);
+   FrozenIntSet sharedOdd;
+   sharedOdd.open(path, true);
+   atomic<bool> done(false);
+   atomic<int> wrong(0), opened(0);
+   vector<thread> workers;
+   workers.push_back(thread([&odd, &even, &done, path, spare]
+   {
+      for (int i = 0; i < 200; ++i)
+      {
+         FrozenIntSet::write(i % 2 == 0 ? even : odd, spare);
+         rename(spare, path);
+      }
+      done = true;
+   }));
+   for (int t = 0; t < threads; ++t)
+      workers.push_back(thread([&odd, &even, &sharedOdd, &done, &wrong,
+                                &opened, path]
+      {
+         do
+         {
+            FrozenIntSet mine;
+            if (!mine.open(path, true))
+               ++wrong;
+            const IntSet& expected = mine.contains(-1) ? even : odd;
+            if (mine.size() != expected.size() ||
+                mine.intersectionSize(expected) != expected.size())
+               ++wrong;
+            ++opened;
+            if (sharedOdd.intersectionSize(odd) != odd.size() ||
+                sharedOdd.contains(-1) || !sharedOdd.isSubsetOf(odd))
+               ++wrong;
+         } while (!done);
+      }));
+   for (size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+   check(wrong == 0 && opened >= threads, test,
+         "readers see the old set or the new one, whole");
+   sharedOdd.close();
+   frozen.close();
+   remove(path);
+   remove(spare);
+}
+
+void testUnionAllSizing()
+{
+   const int sets = 50;
+   const int n = 20000;
+   const long intBytes = long(sizeof(int));
+   const char* test = "testUnionAllSizing";
+
+   for (int sorted = 0; sorted < 2; ++sorted)
+   {
+      CountingResource counted;
+      vector<IntSet> inputs;
+      vector<int> values(n);
+      inputs.reserve(sets);
+      for (int s = 0; s < sets; ++s)
+      {   // Each shifted a little from the one before: mostly overlap.
+         inputs.push_back(IntSet(1, &counted));
+         if (sorted == 1)
+            inputs[s].setOrder(IntSet::SORTED_ORDER);
+         for (int v = 0; v < n; ++v)
+            values[v] = (v * 7 + s * 3) % (n + sets * 3);
+         inputs[s].addAll(values.data(), n);
+      }
+      vector<const IntSet*> pointers;
+      IntSet chained(inputs[0]);
+      for (int s = 0; s < sets; ++s)
+      {
+         pointers.push_back(&inputs[s]);
+         chained = chained.unionWith(inputs[s]);
+      }
+
+      long before = counted.liveBytes;
+      counted.peakBytes = before;
+      IntSet all = IntSet::unionAll(pointers.data(), sets);
+      long held = counted.liveBytes - before;
+      check(all == chained && dumpOf(all) == dumpOf(chained), test,
+            "unionAll matches chained unionWiths");
+      // (What all the sets hold between them is sets * n ints; the
+      // result's index, and the scratch table weeding out repeats,
+      // come on top of its array.)
+      check(counted.peakBytes - before < sets / 2 * n * intBytes, test,
+            "unionAll never sizes for every set at once");
+      check(held < 4L * all.size() * intBytes, test,
+            "the result is fitted to its size");
+
+      // Disjoint sets: the result outgrows its first guess, twice
+      // the largest set.
+      vector<int> own(1000);
+      for (int s = 0; s < sets; ++s)
+      {
+         for (int v = 0; v < 1000; ++v)
+            own[v] = -1 - s * 1000 - v;
+         inputs[s].addAll(own.data(), 1000);
+      }
+      chained = inputs[0];
+      for (int s = 0; s < sets; ++s)
+         chained = chained.unionWith(inputs[s]);
+      check(IntSet::unionAll(pointers.data(), sets) == chained, test,
+            "unionAll grows past twice the largest set");
+   }
+}
+
+void testGrowthPolicies()
+{
+   const char* test = "testGrowthPolicies";
+
+   check(IntSet::growGeometric(INT_MAX / 3 * 2) == INT_MAX, test,
+         "growGeometric saturates at INT_MAX");
+   check(IntSet::growGeometric(INT_MAX) == INT_MAX, test,
+         "growGeometric of INT_MAX is INT_MAX");
+   check(IntSet::growDoubling(INT_MAX / 2 + 1) == INT_MAX, test,
+         "growDoubling saturates at INT_MAX");
+   check(IntSet::growDoubling(INT_MAX / 2) == INT_MAX - 1, test,
+         "growDoubling still doubles up to INT_MAX / 2");
+   check(IntSet::growFixedStep(INT_MAX - IntSet::GROWTH_STEP + 1) == INT_MAX,
+         test, "growFixedStep saturates at INT_MAX");
+   check(IntSet::growFixedStep(0) == IntSet::GROWTH_STEP, test,
+         "growFixedStep still adds GROWTH_STEP");
+
+   IntSet is;
+   is.setGrowthPolicy(negativePolicy);
+   for (int v = 0; v < 1000; ++v)
+      is.add(v);
+   check(is.size() == 1000 && is.contains(0) && is.contains(999), test,
+         "an IntSet whose policy overflows still takes every add");
+}
+
+int negativePolicy(int current_capacity)
+{
+   (void)current_capacity;
+   return INT_MIN;
+}